@@ -0,0 +1,208 @@
+// Headless search benchmark: measures how long the search needs to reach a
+// fixed depth with 1, 2, 4, 8 and 16 threads, i.e. the Lazy SMP scaling curve
+
+#include "Evaluate.h"
+#include "Nnue.h"
+#include "Position.h"
+#include "Search.h"
+#include "TransTable.h"
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <cmath>
+
+using std::cout, std::endl, std::vector;
+
+// Middlegame and endgame positions of varied character
+const vector<std::string> benchPositions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP1B1PPP/R2QKB1R w KQ - 0 8",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5p2/6p1/8/7p/8/6PP/6K1 b - - 0 1",
+};
+
+struct BenchResult {
+    int64_t time = 0;
+    uint64_t nodes = 0;
+    uint64_t pawnProbes = 0;
+    uint64_t pawnHits = 0;
+    vector<uint64_t> threadNodes;
+
+    // Logarithms of the growth in nodes per iteration, summed over the positions
+    double branchingLog = 0;
+    int branchingCount = 0;
+
+    // Geometric mean over the positions: how many times more nodes one more ply of depth costs
+    double branchingFactor() const {
+        return branchingCount ? std::exp(branchingLog / branchingCount) : 0.0;
+    }
+};
+
+// Searches every position to the depth from an empty table
+BenchResult runBench(int depth, int threads, int pawnHashMB) {
+    BenchResult result;
+    result.threadNodes.assign(threads, 0);
+
+    Search search;
+    search.setThreads(threads);
+    search.setPawnHash(pawnHashMB);
+
+    for (const auto& fen : benchPositions)
+    {
+        Position pos;
+        pos.setFen(fen);
+
+        SearchReport last;
+        vector<uint64_t> totals;
+        SearchLimits limits;
+        limits.depth = depth;
+
+        TT.clear();
+        search.clearPawnHash();
+
+        auto start = std::chrono::steady_clock::now();
+        search.run(pos, limits, [&last, &totals](const SearchReport& report) {
+            last = report;
+            totals.push_back(report.nodes);
+        });
+        auto end = std::chrono::steady_clock::now();
+
+        result.time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        result.nodes += last.nodes;
+        result.pawnProbes += last.pawnProbes;
+        result.pawnHits += last.pawnHits;
+
+        // The nodes of an iteration are what the total grew by since the report before;
+        // the growth from the first iteration to the last is spread evenly over the plies between
+        size_t count = totals.size();
+
+        if (count >= 2)
+        {
+            uint64_t lastIteration = std::max<uint64_t>(totals[count - 1] - totals[count - 2], 1);
+
+            result.branchingLog += std::log(static_cast<double>(lastIteration) / std::max<uint64_t>(totals[0], 1)) / (count - 1);
+            result.branchingCount++;
+        }
+
+        for (int i = 0; i < static_cast<int>(last.threadNodes.size()); i++)
+        {
+            result.threadNodes[i] += last.threadNodes[i];
+        }
+    }
+
+    return result;
+}
+
+void printUsage() {
+    cout << "usage: Bench [options]" << endl
+        << "  --depth N         depth every position is searched to (default 9)" << endl
+        << "  --threads LIST    comma-separated thread counts (default 1,2,4,8,16)" << endl
+        << "  --hash MB         transposition table size (default 64)" << endl
+        << "  --pawn-hash MB    pawn structure table size per thread (default " << DefaultPawnHashMB << ")" << endl
+        << "  --nnue FILE       evaluate with the network" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int depth = 9;
+    int hashMB = 64;
+    int pawnHashMB = DefaultPawnHashMB;
+    vector<int> threadCounts = { 1, 2, 4, 8, 16 };
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--depth" && i + 1 < argc)
+        {
+            depth = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--hash" && i + 1 < argc)
+        {
+            hashMB = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--pawn-hash" && i + 1 < argc)
+        {
+            pawnHashMB = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--nnue" && i + 1 < argc)
+        {
+            std::string path = argv[++i];
+
+            if (!nnue.load(path))
+            {
+                std::cerr << "Cannot load network " << path << endl;
+                return 2;
+            }
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            std::stringstream list(argv[++i]);
+            std::string item;
+
+            threadCounts.clear();
+
+            while (std::getline(list, item, ','))
+            {
+                threadCounts.push_back(std::max(1, std::stoi(item)));
+            }
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    initBitboards();
+    TT.resize(hashMB);
+
+    cout << "Time to depth " << depth << " over " << benchPositions.size() << " positions, "
+        << hashMB << " MB hash, " << pawnHashMB << " MB pawn hash per thread, " << std::thread::hardware_concurrency() << " hardware threads, "
+        << evaluationName() << " evaluation" << endl << endl;
+
+    cout << std::setw(8) << "threads" << std::setw(10) << "time ms" << std::setw(10) << "speedup"
+        << std::setw(14) << "nodes" << std::setw(12) << "nps" << std::setw(14) << "nps/thread"
+        << std::setw(12) << "pawn hits" << std::setw(8) << "EBF" << endl;
+
+    int64_t baseTime = 0;
+
+    for (int threads : threadCounts)
+    {
+        BenchResult result = runBench(depth, threads, pawnHashMB);
+        int64_t time = std::max<int64_t>(result.time, 1);
+
+        if (!baseTime)
+        {
+            baseTime = time;
+        }
+
+        uint64_t nps = result.nodes * 1000 / time;
+
+        cout << std::setw(8) << threads << std::setw(10) << result.time
+            << std::setw(10) << std::fixed << std::setprecision(2) << static_cast<double>(baseTime) / time
+            << std::setw(14) << result.nodes << std::setw(12) << nps << std::setw(14) << nps / threads
+            << std::setw(11) << (result.pawnProbes ? 100.0 * result.pawnHits / result.pawnProbes : 0.0) << '%'
+            << std::setw(8) << result.branchingFactor() << endl;
+
+        cout << "        per thread nps:";
+
+        for (uint64_t nodes : result.threadNodes)
+        {
+            cout << ' ' << nodes * 1000 / time;
+        }
+
+        cout << endl;
+    }
+
+    return 0;
+}
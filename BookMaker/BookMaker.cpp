@@ -0,0 +1,181 @@
+// Builds a Polyglot opening book from a PGN collection: every move played in
+// the opening phase of the games is counted with the points it scored, and
+// moves played often enough and scoring well enough go into the book
+
+#include "Position.h"
+#include "Pgn.h"
+#include "Book.h"
+#include "MappedFile.h"
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+
+using std::cout, std::endl, std::vector;
+
+// How a move did over all the games it was played in
+struct MoveStats {
+    uint32_t games = 0;
+    uint32_t points = 0; // two per win and one per draw for the side that played it
+};
+
+struct EntryKey {
+    uint64_t key;
+    uint16_t move;
+
+    bool operator==(const EntryKey& other) const {
+        return key == other.key && move == other.move;
+    }
+};
+
+struct EntryKeyHash {
+    size_t operator()(const EntryKey& entry) const {
+        return static_cast<size_t>(entry.key ^ (static_cast<uint64_t>(entry.move) * 0x9E3779B97F4A7C15ULL));
+    }
+};
+
+void printUsage() {
+    cout << "usage: BookMaker <games.pgn> <book.bin> [options]" << endl
+        << "  --plies N       only the first N plies of every game go into the book (default 24)" << endl
+        << "  --min-games N   a move must have been played at least N times (default 3)" << endl
+        << "  --min-score P   and scored at least P percent for the side that played it (default 40)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int maxPlies = 24;
+    uint32_t minGames = 3;
+    int minScore = 40;
+    vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--plies" && i + 1 < argc)
+        {
+            maxPlies = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--min-games" && i + 1 < argc)
+        {
+            minGames = static_cast<uint32_t>(std::max(1, std::stoi(argv[++i])));
+        }
+        else if (arg == "--min-score" && i + 1 < argc)
+        {
+            minScore = std::clamp(std::stoi(argv[++i]), 0, 100);
+        }
+        else if (!arg.empty() && arg[0] != '-' && paths.size() < 2)
+        {
+            paths.push_back(arg);
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    if (paths.size() != 2)
+    {
+        printUsage();
+        return 2;
+    }
+
+    MappedFile file;
+
+    if (!file.open(paths[0]))
+    {
+        std::cerr << "Cannot open " << paths[0] << endl;
+        return 2;
+    }
+
+    initBitboards();
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::unordered_map<EntryKey, MoveStats, EntryKeyHash> stats;
+    PgnReader reader(file.data());
+    PgnGame game;
+    Position pos;
+    std::string error;
+    uint64_t games = 0, skipped = 0;
+
+    while (reader.next(game))
+    {
+        // Points of the result for white; unfinished games tell nothing about the moves
+        int whitePoints;
+
+        if (game.result == "1-0") whitePoints = 2;
+        else if (game.result == "0-1") whitePoints = 0;
+        else if (game.result == "1/2-1/2") whitePoints = 1;
+        else
+        {
+            skipped++;
+            continue;
+        }
+
+        // Only the opening is replayed; replayGame needs no more moves than that
+        game.moves.resize(std::min<size_t>(game.moves.size(), maxPlies));
+
+        vector<std::pair<EntryKey, int>> played;
+
+        bool legal = replayGame(game, pos, error, [&played, whitePoints](const Position& before, Move move) {
+            int points = (before.sideToMove() == ComandColor::White) ? whitePoints : 2 - whitePoints;
+            played.push_back({ { polyglotKey(before), toPolyglotMove(move) }, points });
+        });
+
+        if (!legal)
+        {
+            skipped++;
+            continue;
+        }
+
+        for (const auto& [entry, points] : played)
+        {
+            MoveStats& moveStats = stats[entry];
+            moveStats.games++;
+            moveStats.points += points;
+        }
+
+        games++;
+    }
+
+    vector<BookEntry> entries;
+
+    for (const auto& [entry, moveStats] : stats)
+    {
+        if (moveStats.games < minGames || moveStats.points * 100 < moveStats.games * 2 * minScore)
+        {
+            continue;
+        }
+
+        BookEntry book;
+
+        book.key = entry.key;
+        book.move = entry.move;
+        book.weight = static_cast<uint16_t>(std::min<uint32_t>(moveStats.points, 0xFFFF));
+
+        // A move that only ever lost or drew still deserves a small chance
+        book.weight = std::max<uint16_t>(book.weight, 1);
+
+        entries.push_back(book);
+    }
+
+    if (!writeBook(paths[1], entries))
+    {
+        std::cerr << "Cannot write " << paths[1] << endl;
+        return 2;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    cout << games << " games read, " << skipped << " skipped, " << stats.size() << " distinct moves, "
+        << entries.size() << " written to " << paths[1] << " in " << std::fixed << std::setprecision(2) << seconds << " s" << endl;
+
+    return 0;
+}
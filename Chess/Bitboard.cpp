@@ -0,0 +1,202 @@
+#include "Bitboard.h"
+
+Magic rookMagics[SquareCount];
+Magic bishopMagics[SquareCount];
+
+Bitboard knightAttackTable[SquareCount];
+Bitboard kingAttackTable[SquareCount];
+Bitboard pawnAttackTable[2][SquareCount];
+
+Bitboard betweenTable[SquareCount][SquareCount];
+Bitboard lineTable[SquareCount][SquareCount];
+
+namespace {
+
+Bitboard rookTable[0x19000];
+Bitboard bishopTable[0x1480];
+
+const int rookDirections[4][2] = { {  1,  0 }, { -1,  0 }, {  0,  1 }, {  0, -1 } };
+const int bishopDirections[4][2] = { {  1,  1 }, {  1, -1 }, { -1,  1 }, { -1, -1 } };
+
+const int knightSteps[8][2] = {
+    { -1, -2 }, {  1, -2 }, { -2, -1 }, {  2, -1 },
+    { -2,  1 }, {  2,  1 }, { -1,  2 }, {  1,  2 },
+};
+
+const int kingSteps[8][2] = {
+    {  1,  0 }, { -1,  0 }, {  0,  1 }, {  0, -1 },
+    {  1,  1 }, {  1, -1 }, { -1,  1 }, { -1, -1 },
+};
+
+// xorshift64* generator, fixed seeds keep the magic search deterministic
+class Random {
+private:
+    uint64_t state;
+
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    }
+
+    uint64_t sparse() {
+        return next() & next() & next();
+    }
+};
+
+// Walks every ray until the edge or the first blocker (inclusive)
+Bitboard slidingAttacks(int square, Bitboard occupied, const int (&directions)[4][2]) {
+    Bitboard attacks = 0;
+
+    for (const auto& direction : directions)
+    {
+        int file = fileOf(square) + direction[0];
+        int rank = rankOf(square) + direction[1];
+
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+        {
+            Bitboard bb = squareBB(makeSquare(file, rank));
+            attacks |= bb;
+
+            if (occupied & bb)
+            {
+                break;
+            }
+
+            file += direction[0];
+            rank += direction[1];
+        }
+    }
+
+    return attacks;
+}
+
+template <int N>
+Bitboard stepAttacks(int square, const int (&steps)[N][2]) {
+    Bitboard attacks = 0;
+
+    for (const auto& step : steps)
+    {
+        int file = fileOf(square) + step[0];
+        int rank = rankOf(square) + step[1];
+
+        if (file >= 0 && file < 8 && rank >= 0 && rank < 8)
+        {
+            attacks |= squareBB(makeSquare(file, rank));
+        }
+    }
+
+    return attacks;
+}
+
+void initMagics(Magic magics[], Bitboard table[], const int (&directions)[4][2]) {
+    static Bitboard occupancy[4096];
+    static Bitboard reference[4096];
+    int size = 0;
+
+#if !defined(USE_PEXT)
+    const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+
+    static int epoch[4096];
+    int attempt = 0;
+#endif
+
+    for (int square = 0; square < SquareCount; square++)
+    {
+        Magic& m = magics[square];
+
+        // Edge squares never block a ray that ends on them, so they are left out of the mask
+        Bitboard edges = ((Rank1BB | Rank8BB) & ~(Rank1BB << (8 * rankOf(square))))
+            | ((FileABB | FileHBB) & ~(FileABB << fileOf(square)));
+
+        m.mask = slidingAttacks(square, 0, directions) & ~edges;
+        m.shift = 64 - popCount(m.mask);
+        m.attacks = square == 0 ? table : magics[square - 1].attacks + size;
+
+        // Enumerate every subset of the mask (Carry-Rippler)
+        Bitboard b = 0;
+        size = 0;
+
+        do
+        {
+            occupancy[size] = b;
+            reference[size] = slidingAttacks(square, b, directions);
+#if defined(USE_PEXT)
+            m.attacks[m.index(occupancy[size])] = reference[size];
+#endif
+            size++;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+#if !defined(USE_PEXT)
+        Random rng(seeds[rankOf(square)]);
+
+        // Try random sparse candidates until one maps every subset without a destructive collision
+        for (int i = 0; i < size; )
+        {
+            for (m.magic = 0; popCount((m.magic * m.mask) >> 56) < 6; )
+            {
+                m.magic = rng.sparse();
+            }
+
+            for (++attempt, i = 0; i < size; ++i)
+            {
+                unsigned index = m.index(occupancy[i]);
+
+                if (epoch[index] < attempt)
+                {
+                    epoch[index] = attempt;
+                    m.attacks[index] = reference[i];
+                }
+                else if (m.attacks[index] != reference[i])
+                {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+}
+
+void initBitboards() {
+    for (int square = 0; square < SquareCount; square++)
+    {
+        knightAttackTable[square] = stepAttacks(square, knightSteps);
+        kingAttackTable[square] = stepAttacks(square, kingSteps);
+        pawnAttackTable[0][square] = shiftBB(squareBB(square), 7) | shiftBB(squareBB(square), 9);
+        pawnAttackTable[1][square] = shiftBB(squareBB(square), -7) | shiftBB(squareBB(square), -9);
+    }
+
+    initMagics(rookMagics, rookTable, rookDirections);
+    initMagics(bishopMagics, bishopTable, bishopDirections);
+
+    for (int from = 0; from < SquareCount; from++)
+    {
+        for (int to = 0; to < SquareCount; to++)
+        {
+            Bitboard pair = squareBB(from) | squareBB(to);
+
+            if (from == to)
+            {
+                continue;
+            }
+
+            if (rookAttacks(from, 0) & squareBB(to))
+            {
+                betweenTable[from][to] = rookAttacks(from, pair) & rookAttacks(to, pair);
+                lineTable[from][to] = (rookAttacks(from, 0) & rookAttacks(to, 0)) | pair;
+            }
+            else if (bishopAttacks(from, 0) & squareBB(to))
+            {
+                betweenTable[from][to] = bishopAttacks(from, pair) & bishopAttacks(to, pair);
+                lineTable[from][to] = (bishopAttacks(from, 0) & bishopAttacks(to, 0)) | pair;
+            }
+        }
+    }
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// PEXT replaces the magic multiply on CPUs with BMI2, build with USE_PEXT
+// (or -mbmi2) to enable it
+#if defined(__BMI2__) && !defined(USE_PEXT)
+#define USE_PEXT
+#endif
+
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// One bit per square: a1 = bit 0, b1 = bit 1, ..., h8 = bit 63.
+// Files run along the x axis of the window, ranks along the y axis.
+using Bitboard = uint64_t;
+
+constexpr int SquareCount = 64;
+constexpr int SquareNone = 64;
+
+constexpr Bitboard FileABB = 0x0101010101010101ULL;
+constexpr Bitboard FileHBB = FileABB << 7;
+constexpr Bitboard Rank1BB = 0xFFULL;
+constexpr Bitboard Rank2BB = Rank1BB << 8;
+constexpr Bitboard Rank3BB = Rank1BB << 16;
+constexpr Bitboard Rank6BB = Rank1BB << 40;
+constexpr Bitboard Rank7BB = Rank1BB << 48;
+constexpr Bitboard Rank8BB = Rank1BB << 56;
+
+enum class ComandColor {
+    White, Black
+};
+
+enum class PieceType {
+    Pawn, Knight, Bishop, Rook, Queen, King, None
+};
+
+constexpr ComandColor opponent(ComandColor color) {
+    return color == ComandColor::White ? ComandColor::Black : ComandColor::White;
+}
+
+constexpr Bitboard squareBB(int square) {
+    return 1ULL << square;
+}
+
+constexpr int makeSquare(int file, int rank) {
+    return rank * 8 + file;
+}
+
+constexpr int fileOf(int square) {
+    return square & 7;
+}
+
+constexpr int rankOf(int square) {
+    return square >> 3;
+}
+
+// Shifts every bit one step towards north (+8), south (-8) or a diagonal (+-7, +-9),
+// dropping what would wrap around the a/h files
+constexpr Bitboard shiftBB(Bitboard b, int direction) {
+    return direction == 8 ? b << 8
+        : direction == -8 ? b >> 8
+        : direction == 9 ? (b & ~FileHBB) << 9
+        : direction == 7 ? (b & ~FileABB) << 7
+        : direction == -7 ? (b & ~FileHBB) >> 7
+        : direction == -9 ? (b & ~FileABB) >> 9
+        : 0;
+}
+
+inline int popCount(Bitboard b) {
+#if defined(_MSC_VER) && defined(_WIN64)
+    return static_cast<int>(__popcnt64(b));
+#elif defined(_MSC_VER)
+    return static_cast<int>(__popcnt(static_cast<unsigned>(b)) + __popcnt(static_cast<unsigned>(b >> 32)));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Index of the least significant set bit, b must not be empty
+inline int lsb(Bitboard b) {
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return static_cast<int>(index);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (static_cast<unsigned>(b))
+    {
+        _BitScanForward(&index, static_cast<unsigned>(b));
+        return static_cast<int>(index);
+    }
+    _BitScanForward(&index, static_cast<unsigned>(b >> 32));
+    return static_cast<int>(index + 32);
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+inline int popLsb(Bitboard& b) {
+    int square = lsb(b);
+    b &= b - 1;
+    return square;
+}
+
+// Slider attacks are looked up in tables indexed by the relevant occupancy
+// bits of a square, hashed with a magic multiplier or extracted with PEXT.
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard* attacks;
+    unsigned shift;
+
+    unsigned index(Bitboard occupied) const {
+#if defined(USE_PEXT)
+        return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Magic rookMagics[SquareCount];
+extern Magic bishopMagics[SquareCount];
+
+extern Bitboard knightAttackTable[SquareCount];
+extern Bitboard kingAttackTable[SquareCount];
+extern Bitboard pawnAttackTable[2][SquareCount];
+
+extern Bitboard betweenTable[SquareCount][SquareCount];
+extern Bitboard lineTable[SquareCount][SquareCount];
+
+// Fills the attack tables, must run once before any move generation
+void initBitboards();
+
+inline Bitboard rookAttacks(int square, Bitboard occupied) {
+    const Magic& m = rookMagics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard bishopAttacks(int square, Bitboard occupied) {
+    const Magic& m = bishopMagics[square];
+    return m.attacks[m.index(occupied)];
+}
+
+inline Bitboard queenAttacks(int square, Bitboard occupied) {
+    return rookAttacks(square, occupied) | bishopAttacks(square, occupied);
+}
+
+inline Bitboard knightAttacks(int square) {
+    return knightAttackTable[square];
+}
+
+inline Bitboard kingAttacks(int square) {
+    return kingAttackTable[square];
+}
+
+// Squares a pawn of the given color standing on square attacks
+inline Bitboard pawnAttacks(ComandColor color, int square) {
+    return pawnAttackTable[static_cast<int>(color)][square];
+}
+
+inline Bitboard attacksFrom(PieceType type, int square, Bitboard occupied) {
+    switch (type)
+    {
+    case PieceType::Knight: return knightAttacks(square);
+    case PieceType::Bishop: return bishopAttacks(square, occupied);
+    case PieceType::Rook: return rookAttacks(square, occupied);
+    case PieceType::Queen: return queenAttacks(square, occupied);
+    case PieceType::King: return kingAttacks(square);
+    default: return 0;
+    }
+}
+
+// Squares strictly between two squares on a common rank, file or diagonal, empty otherwise
+inline Bitboard between(int from, int to) {
+    return betweenTable[from][to];
+}
+
+// The whole rank, file or diagonal through both squares, empty if they are not aligned
+inline Bitboard line(int from, int to) {
+    return lineTable[from][to];
+}
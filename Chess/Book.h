@@ -0,0 +1,69 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Position.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// One record of a Polyglot .bin book: 16 bytes, big-endian, the file sorted by key.
+// The move packs the to-square in bits 0-5, the from-square in bits 6-11 and the
+// promotion piece (1 knight .. 4 queen) in bits 12-14; castling is written as
+// the king taking its own rook.
+struct BookEntry {
+    uint64_t key = 0;
+    uint16_t move = 0;
+    uint16_t weight = 0;
+    uint32_t learn = 0;
+};
+
+struct BookMove {
+    Move move;
+    int weight = 0;
+};
+
+// Polyglot hash key of a position, the key the records of every .bin book are sorted by
+uint64_t polyglotKey(const Position& pos);
+
+// Polyglot move code of a move
+uint16_t toPolyglotMove(Move move);
+
+// Sorts the entries by key, heaviest move first, and writes them as a .bin book
+bool writeBook(const std::string& path, std::vector<BookEntry>& entries);
+
+// Opening book in the Polyglot file format. The file is memory-mapped and
+// entries are decoded in place during a binary search, so a lookup reads a
+// few cache lines and copies nothing.
+class OpeningBook {
+private:
+    MappedFile file;
+    const unsigned char* bytes = nullptr;
+    size_t count = 0;
+    std::mt19937_64 random{ std::random_device{}() };
+
+    BookEntry entry(size_t index) const;
+
+public:
+    static constexpr size_t EntrySize = 16;
+
+    // Returns false if the file cannot be mapped or is not a whole number of entries
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const {
+        return bytes != nullptr;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // Legal book moves of the position with their weights, heaviest first
+    std::vector<BookMove> probe(const Position& pos) const;
+
+    // A book move chosen at random in proportion to the weights, or the heaviest
+    // one if best is set; Move::none() when the position is not in the book
+    Move pick(const Position& pos, bool best = false);
+};
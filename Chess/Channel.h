@@ -0,0 +1,39 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+
+// Message queue between two threads. tryPop never waits: if the other side
+// holds the lock at that moment it simply reports an empty queue, so a
+// render loop can poll it every frame without stalling.
+template <typename T>
+class Channel {
+private:
+    std::deque<T> queue;
+    std::mutex mutex;
+
+public:
+    void push(T value) {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(value));
+    }
+
+    bool tryPop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+
+        if (!lock.owns_lock() || queue.empty())
+        {
+            return false;
+        }
+
+        value = std::move(queue.front());
+        queue.pop_front();
+        return true;
+    }
+
+    // Waits for the lock, so everything pushed before the call is seen
+    bool empty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.empty();
+    }
+};
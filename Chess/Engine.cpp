@@ -0,0 +1,48 @@
+#include "Engine.h"
+
+Engine::~Engine() {
+    wait();
+}
+
+void Engine::start(const Position& pos, const SearchLimits& limits) {
+    wait();
+
+    search.resetStop();
+    busy = true;
+
+    worker = std::thread([this, root = pos, limits]() {
+        uint64_t key = root.key();
+
+        Move move = search.run(root, limits, [this, key](const SearchReport& report) {
+            EngineMessage message;
+
+            message.type = EngineMessage::Info;
+            message.report = report;
+            message.positionKey = key;
+
+            messages.push(std::move(message));
+        });
+
+        EngineMessage message;
+
+        message.type = EngineMessage::BestMove;
+        message.move = move;
+        message.positionKey = key;
+
+        messages.push(std::move(message));
+        busy = false;
+    });
+}
+
+void Engine::stop() {
+    search.stop();
+}
+
+void Engine::wait() {
+    search.stop();
+
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Channel.h"
+#include "Search.h"
+
+#include <atomic>
+#include <thread>
+
+// What the search thread reports back. positionKey identifies the position
+// the search was started on, so a stale result can be recognised and dropped.
+struct EngineMessage {
+    enum Type {
+        Info, BestMove
+    };
+
+    Type type = Info;
+    SearchReport report;
+    Move move = Move::none();
+    uint64_t positionKey = 0;
+};
+
+// Runs the search on a background thread. Progress and the final move
+// arrive through poll(); after stop() the best move found so far is
+// delivered as a BestMove message.
+class Engine {
+private:
+    Search search;
+    std::thread worker;
+    Channel<EngineMessage> messages;
+    std::atomic<bool> busy{ false };
+
+public:
+    ~Engine();
+
+    // Number of search threads (Lazy SMP); waits for a running search to finish
+    void setThreads(int count) {
+        wait();
+        search.setThreads(count);
+    }
+
+    // Starts thinking on a copy of the position, stopping any previous search first
+    void start(const Position& pos, const SearchLimits& limits);
+
+    // Asks the search to finish; does not wait for it
+    void stop();
+
+    // Stops the search and waits for the thread to exit
+    void wait();
+
+    bool thinking() const {
+        return busy;
+    }
+
+    // Best move of the running search so far
+    Move bestMove() const {
+        return search.bestMove();
+    }
+
+    bool poll(EngineMessage& message) {
+        return messages.tryPop(message);
+    }
+
+    // Unlike poll, certain to see a message pushed before the call
+    bool hasMessages() {
+        return !messages.empty();
+    }
+};
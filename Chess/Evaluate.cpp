@@ -0,0 +1,59 @@
+#include "Evaluate.h"
+
+namespace {
+
+#if defined(EVAL_MATERIAL)
+int materialScore(const Position& pos) {
+    int score = 0;
+
+    for (int type = 0; type < 5; type++)
+    {
+        PieceType piece = static_cast<PieceType>(type);
+
+        score += PieceValue[type] * (popCount(pos.pieces(ComandColor::White, piece)) - popCount(pos.pieces(ComandColor::Black, piece)));
+    }
+
+    return score;
+}
+#else
+// The position keeps the sums up to date as pieces move, and the pawn terms
+// mostly come from the table, so little more than the blend is left
+int psqtScore(const Position& pos, PawnTable& pawns) {
+    TaperedScore psq = pos.psq();
+    int phase = pos.phase();
+
+    psq += evaluatePawns(pos, pawns);
+
+    return (psq.mg * phase + psq.eg * (MaxPhase - phase)) / MaxPhase;
+}
+#endif
+
+}
+
+int evaluate(const Position& pos, EvalState& state) {
+#if defined(EVAL_NNUE)
+    if (nnue.isLoaded())
+    {
+        return nnue.evaluate(pos, state.accumulators);
+    }
+#endif
+
+#if defined(EVAL_MATERIAL)
+    (void)state;
+    int score = materialScore(pos);
+#else
+    int score = psqtScore(pos, state.pawns);
+#endif
+
+    return (pos.sideToMove() == ComandColor::White) ? score : -score;
+}
+
+const char* evaluationName() {
+#if defined(EVAL_MATERIAL)
+    return "material";
+#elif defined(EVAL_PSQT)
+    return "piece-square";
+#else
+    return nnue.isLoaded() ? "network" : "piece-square";
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Nnue.h"
+#include "Pawns.h"
+#include "Position.h"
+
+// The evaluation is chosen when building, so benchmarks can compare them on
+// the same searches: EVAL_MATERIAL counts material, EVAL_PSQT blends the
+// middlegame and endgame piece-square scores and adds the cached pawn
+// structure terms, EVAL_NNUE (the default) uses the network when one is
+// loaded and EVAL_PSQT's scores otherwise.
+#if !defined(EVAL_MATERIAL) && !defined(EVAL_PSQT) && !defined(EVAL_NNUE)
+#define EVAL_NNUE
+#endif
+
+// Material values in centipawns, indexed by PieceType
+constexpr int PieceValue[6] = { 100, 320, 330, 500, 900, 0 };
+
+// What the evaluation keeps between calls of one search thread, so that it
+// can be updated from the previous positions instead of recomputed
+struct EvalState {
+    NnueAccumulators accumulators;
+    PawnTable pawns;
+};
+
+// Static score of the position from the point of view of the side to move
+int evaluate(const Position& pos, EvalState& state);
+
+// Name of the evaluation in use, for reports
+const char* evaluationName();
@@ -0,0 +1,143 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+bool MappedFile::open(const std::string& path, FileAccess access) {
+    close();
+
+    DWORD hint = (access == FileAccess::Sequential) ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, hint, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    length = static_cast<size_t>(fileSize.QuadPart);
+    opened = true;
+
+    // Windows cannot map an empty file
+    if (length == 0)
+    {
+        return true;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (!mapping)
+    {
+        close();
+        return false;
+    }
+
+    mappingHandle = mapping;
+    bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+    if (!bytes)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes)
+    {
+        UnmapViewOfFile(bytes);
+    }
+
+    if (mappingHandle)
+    {
+        CloseHandle(mappingHandle);
+    }
+
+    if (fileHandle)
+    {
+        CloseHandle(fileHandle);
+    }
+
+    bytes = nullptr;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string& path, FileAccess access) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+
+    if (fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+
+    if (length > 0)
+    {
+        void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapped == MAP_FAILED)
+        {
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+
+        madvise(mapped, length, access == FileAccess::Sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        bytes = static_cast<const char*>(mapped);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    ::close(fd);
+    opened = true;
+
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes)
+    {
+        munmap(const_cast<char*>(bytes), length);
+    }
+
+    bytes = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
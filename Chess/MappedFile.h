@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// How a mapped file will be read, so the operating system reads ahead
+// (sequential) or fetches only the pages touched (random)
+enum class FileAccess {
+    Sequential, Random
+};
+
+// Read-only memory mapping of a whole file. The operating system pages the
+// contents in on demand, so even files larger than memory can be scanned
+// front to back without reading them into a buffer first.
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+
+#if defined(_WIN32)
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path, FileAccess access = FileAccess::Sequential) {
+        open(path, access);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Returns false if the file cannot be opened or mapped; an empty file maps to an empty view
+    bool open(const std::string& path, FileAccess access = FileAccess::Sequential);
+    void close();
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    std::string_view data() const {
+        return std::string_view(bytes, length);
+    }
+
+    size_t size() const {
+        return length;
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Bitboard.h"
+
+#include <string>
+
+// A move packed into 16 bits: from square (bits 0-5), to square (bits 6-11)
+// and flags (bits 12-15). Promotions keep the promoted piece in the low two
+// flag bits, so a promotion capture to a queen is Promotion | Capture | 3.
+class Move {
+private:
+    uint16_t data;
+
+public:
+    enum Flag {
+        Quiet = 0,
+        DoublePush = 1,
+        KingCastle = 2,
+        QueenCastle = 3,
+        Capture = 4,
+        EnPassant = 5,
+        Promotion = 8
+    };
+
+    Move() = default;
+
+    constexpr Move(int from, int to, int flags = Quiet)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+    static constexpr Move none() {
+        return Move(0, 0);
+    }
+
+    constexpr int from() const {
+        return data & 0x3F;
+    }
+
+    constexpr int to() const {
+        return (data >> 6) & 0x3F;
+    }
+
+    constexpr int flags() const {
+        return data >> 12;
+    }
+
+    constexpr bool isCapture() const {
+        return (flags() & Capture) != 0;
+    }
+
+    constexpr bool isPromotion() const {
+        return (flags() & Promotion) != 0;
+    }
+
+    constexpr bool isCastle() const {
+        return flags() == KingCastle || flags() == QueenCastle;
+    }
+
+    constexpr PieceType promotionType() const {
+        return static_cast<PieceType>(static_cast<int>(PieceType::Knight) + (flags() & 3));
+    }
+
+    // Coordinate notation, e.g. "e2e4" or "e7e8q"
+    std::string toString() const {
+        std::string text{
+            static_cast<char>('a' + fileOf(from())), static_cast<char>('1' + rankOf(from())),
+            static_cast<char>('a' + fileOf(to())), static_cast<char>('1' + rankOf(to()))
+        };
+
+        if (isPromotion())
+        {
+            text += "nbrq"[flags() & 3];
+        }
+
+        return text;
+    }
+
+    constexpr uint16_t raw() const {
+        return data;
+    }
+
+    constexpr bool operator==(const Move& other) const {
+        return data == other.data;
+    }
+
+    constexpr bool operator!=(const Move& other) const {
+        return data != other.data;
+    }
+};
+
+// Enough for any reachable position (the known maximum is 218 legal moves)
+constexpr int MaxMoves = 256;
+
+// Fixed-capacity move list meant to live on the caller's stack
+class MoveList {
+private:
+    Move moves[MaxMoves];
+    int count = 0;
+
+public:
+    void add(Move move) {
+        moves[count++] = move;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    int size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    Move operator[](int index) const {
+        return moves[index];
+    }
+
+    Move* begin() {
+        return moves;
+    }
+
+    Move* end() {
+        return moves + count;
+    }
+
+    const Move* begin() const {
+        return moves;
+    }
+
+    const Move* end() const {
+        return moves + count;
+    }
+
+    bool contains(Move move) const {
+        for (int i = 0; i < count; i++)
+        {
+            if (moves[i] == move)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
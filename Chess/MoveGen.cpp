@@ -0,0 +1,243 @@
+#include "MoveGen.h"
+
+namespace {
+
+void addPromotions(MoveList& moves, int from, int to, int flags) {
+    for (int piece = 3; piece >= 0; piece--)
+    {
+        moves.add(Move(from, to, flags | Move::Promotion | piece));
+    }
+}
+
+// Pushes, captures and promotions of the given pawns that land on targetMask
+void generatePawnMoves(const Position& pos, MoveList& moves, Bitboard pawns, Bitboard targetMask) {
+    ComandColor us = pos.sideToMove();
+
+    int up = (us == ComandColor::White) ? 8 : -8;
+    int upLeft = up - 1;
+    int upRight = up + 1;
+
+    Bitboard lastRank = (us == ComandColor::White) ? Rank7BB : Rank2BB;
+    Bitboard doubleRank = (us == ComandColor::White) ? Rank3BB : Rank6BB;
+
+    Bitboard empty = ~pos.pieces();
+    Bitboard enemies = pos.pieces(opponent(us)) & targetMask;
+
+    Bitboard promoting = pawns & lastRank;
+    Bitboard others = pawns & ~lastRank;
+
+    // Pushes
+    Bitboard single = shiftBB(others, up) & empty;
+    Bitboard twice = shiftBB(single & doubleRank, up) & empty & targetMask;
+
+    single &= targetMask;
+
+    while (single)
+    {
+        int to = popLsb(single);
+        moves.add(Move(to - up, to));
+    }
+
+    while (twice)
+    {
+        int to = popLsb(twice);
+        moves.add(Move(to - 2 * up, to, Move::DoublePush));
+    }
+
+    // Captures
+    Bitboard left = shiftBB(others, upLeft) & enemies;
+    Bitboard right = shiftBB(others, upRight) & enemies;
+
+    while (left)
+    {
+        int to = popLsb(left);
+        moves.add(Move(to - upLeft, to, Move::Capture));
+    }
+
+    while (right)
+    {
+        int to = popLsb(right);
+        moves.add(Move(to - upRight, to, Move::Capture));
+    }
+
+    // Promotions
+    if (promoting)
+    {
+        Bitboard push = shiftBB(promoting, up) & empty & targetMask;
+        Bitboard promoteLeft = shiftBB(promoting, upLeft) & enemies;
+        Bitboard promoteRight = shiftBB(promoting, upRight) & enemies;
+
+        while (push)
+        {
+            int to = popLsb(push);
+            addPromotions(moves, to - up, to, Move::Quiet);
+        }
+
+        while (promoteLeft)
+        {
+            int to = popLsb(promoteLeft);
+            addPromotions(moves, to - upLeft, to, Move::Capture);
+        }
+
+        while (promoteRight)
+        {
+            int to = popLsb(promoteRight);
+            addPromotions(moves, to - upRight, to, Move::Capture);
+        }
+    }
+}
+
+// En passant can uncover the king along the rank of both pawns, so every
+// candidate is verified against the occupancy after the capture
+void generateEnPassant(const Position& pos, MoveList& moves, Bitboard pawns, int king) {
+    ComandColor us = pos.sideToMove();
+    ComandColor them = opponent(us);
+    int to = pos.enPassantSquare();
+
+    if (to == SquareNone)
+    {
+        return;
+    }
+
+    int captured = to + ((us == ComandColor::White) ? -8 : 8);
+    Bitboard attackers = pawnAttacks(them, to) & pawns;
+
+    while (attackers)
+    {
+        int from = popLsb(attackers);
+        Bitboard occupied = (pos.pieces() ^ squareBB(from) ^ squareBB(captured)) | squareBB(to);
+
+        if (!(pos.attackersTo(king, occupied) & pos.pieces(them) & ~squareBB(captured)))
+        {
+            moves.add(Move(from, to, Move::EnPassant));
+        }
+    }
+}
+
+void generatePieceMoves(const Position& pos, MoveList& moves, PieceType type, Bitboard pieces,
+                        Bitboard pinned, Bitboard targetMask, int king) {
+    ComandColor us = pos.sideToMove();
+    Bitboard enemies = pos.pieces(opponent(us));
+
+    while (pieces)
+    {
+        int from = popLsb(pieces);
+        Bitboard targets = attacksFrom(type, from, pos.pieces()) & ~pos.pieces(us) & targetMask;
+
+        if (pinned & squareBB(from))
+        {
+            targets &= line(king, from);
+        }
+
+        while (targets)
+        {
+            int to = popLsb(targets);
+            moves.add(Move(from, to, (enemies & squareBB(to)) ? Move::Capture : Move::Quiet));
+        }
+    }
+}
+
+void generateKingMoves(const Position& pos, MoveList& moves, int king) {
+    ComandColor us = pos.sideToMove();
+    ComandColor them = opponent(us);
+    Bitboard enemies = pos.pieces(them);
+
+    // The king must not be able to hide behind itself from a slider
+    Bitboard occupied = pos.pieces() ^ squareBB(king);
+    Bitboard targets = kingAttacks(king) & ~pos.pieces(us);
+
+    while (targets)
+    {
+        int to = popLsb(targets);
+
+        if (!(pos.attackersTo(to, occupied) & enemies))
+        {
+            moves.add(Move(king, to, (enemies & squareBB(to)) ? Move::Capture : Move::Quiet));
+        }
+    }
+}
+
+void generateCastling(const Position& pos, MoveList& moves, int king) {
+    ComandColor us = pos.sideToMove();
+    ComandColor them = opponent(us);
+
+    int kingside = (us == ComandColor::White) ? WhiteKingside : BlackKingside;
+    int queenside = (us == ComandColor::White) ? WhiteQueenside : BlackQueenside;
+
+    if ((pos.castling() & kingside)
+        && pos.isEmpty(king + 1) && pos.isEmpty(king + 2)
+        && !pos.isAttacked(king + 1, them) && !pos.isAttacked(king + 2, them))
+    {
+        moves.add(Move(king, king + 2, Move::KingCastle));
+    }
+
+    if ((pos.castling() & queenside)
+        && pos.isEmpty(king - 1) && pos.isEmpty(king - 2) && pos.isEmpty(king - 3)
+        && !pos.isAttacked(king - 1, them) && !pos.isAttacked(king - 2, them))
+    {
+        moves.add(Move(king, king - 2, Move::QueenCastle));
+    }
+}
+
+}
+
+void generateMoves(const Position& pos, MoveList& moves, Bitboard fromMask) {
+    ComandColor us = pos.sideToMove();
+    ComandColor them = opponent(us);
+    int king = pos.kingSquare(us);
+
+    Bitboard ours = pos.pieces(us);
+    Bitboard checkers = pos.attackersTo(king, pos.pieces()) & pos.pieces(them);
+
+    if (fromMask & squareBB(king))
+    {
+        generateKingMoves(pos, moves, king);
+    }
+
+    // In double check only the king can move
+    if (checkers & (checkers - 1))
+    {
+        return;
+    }
+
+    // A single check must be captured or blocked
+    Bitboard targetMask = checkers ? (between(king, lsb(checkers)) | checkers) : ~0ULL;
+
+    // Our pieces that are the only blocker between the king and an enemy slider
+    Bitboard pinned = 0;
+    Bitboard snipers = (rookAttacks(king, 0) & (pos.pieces(them, PieceType::Rook) | pos.pieces(them, PieceType::Queen)))
+        | (bishopAttacks(king, 0) & (pos.pieces(them, PieceType::Bishop) | pos.pieces(them, PieceType::Queen)));
+
+    while (snipers)
+    {
+        Bitboard blockers = between(king, popLsb(snipers)) & pos.pieces();
+
+        if (blockers && !(blockers & (blockers - 1)))
+        {
+            pinned |= blockers & ours;
+        }
+    }
+
+    Bitboard pawns = pos.pieces(us, PieceType::Pawn) & fromMask;
+    Bitboard pinnedPawns = pawns & pinned;
+
+    generatePawnMoves(pos, moves, pawns & ~pinned, targetMask);
+
+    while (pinnedPawns)
+    {
+        int from = popLsb(pinnedPawns);
+        generatePawnMoves(pos, moves, squareBB(from), targetMask & line(king, from));
+    }
+
+    generateEnPassant(pos, moves, pawns, king);
+
+    generatePieceMoves(pos, moves, PieceType::Knight, pos.pieces(us, PieceType::Knight) & fromMask & ~pinned, 0, targetMask, king);
+    generatePieceMoves(pos, moves, PieceType::Bishop, pos.pieces(us, PieceType::Bishop) & fromMask, pinned, targetMask, king);
+    generatePieceMoves(pos, moves, PieceType::Rook, pos.pieces(us, PieceType::Rook) & fromMask, pinned, targetMask, king);
+    generatePieceMoves(pos, moves, PieceType::Queen, pos.pieces(us, PieceType::Queen) & fromMask, pinned, targetMask, king);
+
+    if (!checkers && (fromMask & squareBB(king)))
+    {
+        generateCastling(pos, moves, king);
+    }
+}
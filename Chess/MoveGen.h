@@ -0,0 +1,8 @@
+#pragma once
+
+#include "Position.h"
+#include "Move.h"
+
+// Appends the legal moves of the side to move to the list.
+// Only pieces standing on a square of fromMask are considered.
+void generateMoves(const Position& pos, MoveList& moves, Bitboard fromMask = ~0ULL);
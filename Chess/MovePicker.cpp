@@ -0,0 +1,197 @@
+#include "MovePicker.h"
+
+#include "Evaluate.h"
+#include "MoveGen.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+void MoveHistory::clear() {
+    for (auto& side : butterfly)
+    {
+        for (auto& from : side)
+        {
+            std::fill(std::begin(from), std::end(from), 0);
+        }
+    }
+
+    for (auto& side : counterMoves)
+    {
+        for (auto& piece : side)
+        {
+            std::fill(std::begin(piece), std::end(piece), Move::none());
+        }
+    }
+}
+
+void MoveHistory::age() {
+    for (auto& side : butterfly)
+    {
+        for (auto& from : side)
+        {
+            for (int& score : from)
+            {
+                score /= 2;
+            }
+        }
+    }
+}
+
+// The closer the score already is to the bound, the less a bonus moves it, so it never leaves the range
+void MoveHistory::update(ComandColor us, Move move, int bonus) {
+    int& score = butterfly[static_cast<int>(us)][move.from()][move.to()];
+
+    bonus = std::clamp(bonus, -MaxScore, MaxScore);
+    score += bonus - score * std::abs(bonus) / MaxScore;
+}
+
+MovePicker::MovePicker(const Position& position, Move ttMove, const Move* killers, Move counterMove,
+    const MoveHistory& moveHistory, uint32_t historySalt)
+    : pos(position), history(moveHistory), stage(Stage::HashMove), capturesOnly(false), salt(historySalt), hashMove(ttMove) {
+    for (Move move : { killers[0], killers[1], counterMove })
+    {
+        if (move != Move::none() && move != ttMove && !isNoisy(move)
+            && std::find(refutations, refutations + refutationCount, move) == refutations + refutationCount)
+        {
+            refutations[refutationCount++] = move;
+        }
+    }
+}
+
+MovePicker::MovePicker(const Position& position, const MoveHistory& moveHistory, bool inCheck)
+    : pos(position), history(moveHistory), stage(Stage::Captures), capturesOnly(!inCheck), salt(0), hashMove(Move::none()) {
+    generate();
+}
+
+void MovePicker::generate() {
+    generateMoves(pos, moves);
+
+    captureEnd = static_cast<int>(std::partition(moves.begin(), moves.end(), isNoisy) - moves.begin());
+    current = 0;
+
+    for (int i = 0; i < captureEnd; i++)
+    {
+        Move move = moves[i];
+        PieceType victim = (move.flags() == Move::EnPassant) ? PieceType::Pawn : pos.pieceOn(move.to());
+        int score = move.isCapture() ? 10 * PieceValue[static_cast<int>(victim)] - PieceValue[static_cast<int>(pos.pieceOn(move.from()))] : 0;
+
+        if (move.isPromotion())
+        {
+            score += PieceValue[static_cast<int>(move.promotionType())];
+        }
+
+        scores[i] = score;
+    }
+}
+
+bool MovePicker::isHashOrRefutation(Move move) const {
+    return move == hashMove || std::find(refutations, refutations + refutationCount, move) != refutations + refutationCount;
+}
+
+// Selection sort step: brings the best of the moves left before end to the front
+Move MovePicker::pickBest(int end) {
+    int bestIndex = current;
+
+    for (int i = current + 1; i < end; i++)
+    {
+        if (scores[i] > scores[bestIndex])
+        {
+            bestIndex = i;
+        }
+    }
+
+    std::swap(moves.begin()[current], moves.begin()[bestIndex]);
+    std::swap(scores[current], scores[bestIndex]);
+
+    return moves[current++];
+}
+
+Move MovePicker::next() {
+    while (true)
+    {
+        switch (stage)
+        {
+        case Stage::HashMove:
+            stage = Stage::Generate;
+
+            // Only the moves of the hash move's piece are needed to tell whether it is legal here
+            if (hashMove != Move::none())
+            {
+                MoveList pieceMoves;
+                generateMoves(pos, pieceMoves, squareBB(hashMove.from()));
+
+                if (std::find(pieceMoves.begin(), pieceMoves.end(), hashMove) != pieceMoves.end())
+                {
+                    return hashMove;
+                }
+            }
+
+            break;
+
+        case Stage::Generate:
+            generate();
+            stage = Stage::Captures;
+            break;
+
+        case Stage::Captures:
+            while (current < captureEnd)
+            {
+                Move move = pickBest(captureEnd);
+
+                if (move != hashMove)
+                {
+                    return move;
+                }
+            }
+
+            stage = capturesOnly ? Stage::Done : Stage::Refutations;
+            current = 0;
+            break;
+
+        case Stage::Refutations:
+            // Killers and counter moves come from other positions, so they are only played if they are legal here
+            while (current < refutationCount)
+            {
+                Move move = refutations[current++];
+
+                if (std::find(moves.begin() + captureEnd, moves.end(), move) != moves.end())
+                {
+                    return move;
+                }
+            }
+
+            // The quiet moves are scored only now that they are needed
+            for (int i = captureEnd; i < moves.size(); i++)
+            {
+                Move move = moves[i];
+                scores[i] = history.butterfly[static_cast<int>(pos.sideToMove())][move.from()][move.to()];
+
+                if (salt)
+                {
+                    scores[i] += static_cast<int>((move.raw() * salt) >> 20);
+                }
+            }
+
+            stage = Stage::Quiets;
+            current = captureEnd;
+            break;
+
+        case Stage::Quiets:
+            while (current < moves.size())
+            {
+                Move move = pickBest(moves.size());
+
+                if (!isHashOrRefutation(move))
+                {
+                    return move;
+                }
+            }
+
+            stage = Stage::Done;
+            break;
+
+        case Stage::Done:
+            return Move::none();
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Move.h"
+#include "Position.h"
+
+#include <cstdint>
+
+// Captures and queen promotions change the material; under-promotions are left with the quiet moves
+inline bool isNoisy(Move move) {
+    return move.isCapture() || (move.isPromotion() && move.promotionType() == PieceType::Queen);
+}
+
+// Which quiet moves caused cutoffs in earlier nodes, kept by each search thread
+struct MoveHistory {
+    static constexpr int MaxScore = 16384;
+
+    // Butterfly table: success of a quiet move by side, from and to square
+    int butterfly[2][SquareCount][SquareCount];
+
+    // Reply that refuted a move, by the side, piece and target square of that move
+    Move counterMoves[2][6][SquareCount];
+
+    MoveHistory() {
+        clear();
+    }
+
+    void clear();
+
+    // Halves the scores so a new search learns faster than the old one fades
+    void age();
+
+    // Moves the score towards MaxScore for a bonus, towards -MaxScore for a penalty
+    void update(ComandColor us, Move move, int bonus);
+};
+
+// Hands out the moves of a node best first, one stage at a time: the hash
+// move, captures by most valuable victim and least valuable attacker, the
+// killer and counter moves, and the remaining quiet moves by history. Each
+// stage is only generated and scored when the one before runs out, so a
+// cutoff on an early move saves the work of the later stages.
+class MovePicker {
+private:
+    enum class Stage {
+        HashMove, Generate, Captures, Refutations, Quiets, Done
+    };
+
+    const Position& pos;
+    const MoveHistory& history;
+    Stage stage;
+    bool capturesOnly;
+    uint32_t salt;
+
+    Move hashMove;
+    Move refutations[3];
+    int refutationCount = 0;
+
+    MoveList moves;
+    int scores[MaxMoves];
+    int current = 0;
+    int captureEnd = 0;
+
+    void generate();
+    bool isHashOrRefutation(Move move) const;
+    Move pickBest(int end);
+
+public:
+    // Every move of an inner node. Killers (two, may be none) and the counter
+    // move are tried after the captures if they are legal here; a non-zero salt
+    // adds noise to the history order, which is how helper threads diverge.
+    MovePicker(const Position& position, Move ttMove, const Move* killers, Move counterMove,
+        const MoveHistory& moveHistory, uint32_t historySalt = 0);
+
+    // Quiescence: only captures and queen promotions, unless in check.
+    // All legal moves are generated up front so mate and stalemate are seen.
+    MovePicker(const Position& position, const MoveHistory& moveHistory, bool inCheck);
+
+    // True if the side to move has no legal move; only for the quiescence picker
+    bool noLegalMoves() const {
+        return moves.empty();
+    }
+
+    // The next move to search, Move::none() once all have been handed out
+    Move next();
+};
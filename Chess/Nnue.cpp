@@ -0,0 +1,371 @@
+#include "Nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NNUE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NNUE_SSE2
+#endif
+
+Nnue nnue;
+
+struct Nnue::Weights {
+    alignas(32) int16_t featureBias[NnueHidden];
+    alignas(32) int16_t featureWeights[NnueInputs][NnueHidden];
+    alignas(32) int32_t hiddenBias[NnueLayer1];
+    alignas(32) int8_t hiddenWeights[NnueLayer1][2 * NnueHidden];
+    int32_t outputBias;
+    alignas(32) int8_t outputWeights[NnueLayer1];
+};
+
+namespace {
+
+// A piece as seen from one side: own pieces first, and the board turned over for black
+int featureIndex(ComandColor perspective, ComandColor color, PieceType type, int square) {
+    int relative = (color == perspective) ? 0 : 1;
+    int oriented = (perspective == ComandColor::White) ? square : square ^ 56;
+
+    return (relative * 6 + static_cast<int>(type)) * 64 + oriented;
+}
+
+// out = base + the added columns - the removed ones, in a single pass over the accumulator
+void accumulate(const int16_t* base, int16_t* out, const int16_t* const* added, int addCount, const int16_t* const* removed, int removeCount) {
+#if defined(NNUE_AVX2)
+    for (int i = 0; i < NnueHidden; i += 16)
+    {
+        __m256i sum = _mm256_load_si256(reinterpret_cast<const __m256i*>(base + i));
+
+        for (int c = 0; c < addCount; c++)
+        {
+            sum = _mm256_add_epi16(sum, _mm256_load_si256(reinterpret_cast<const __m256i*>(added[c] + i)));
+        }
+
+        for (int c = 0; c < removeCount; c++)
+        {
+            sum = _mm256_sub_epi16(sum, _mm256_load_si256(reinterpret_cast<const __m256i*>(removed[c] + i)));
+        }
+
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out + i), sum);
+    }
+#elif defined(NNUE_SSE2)
+    for (int i = 0; i < NnueHidden; i += 8)
+    {
+        __m128i sum = _mm_load_si128(reinterpret_cast<const __m128i*>(base + i));
+
+        for (int c = 0; c < addCount; c++)
+        {
+            sum = _mm_add_epi16(sum, _mm_load_si128(reinterpret_cast<const __m128i*>(added[c] + i)));
+        }
+
+        for (int c = 0; c < removeCount; c++)
+        {
+            sum = _mm_sub_epi16(sum, _mm_load_si128(reinterpret_cast<const __m128i*>(removed[c] + i)));
+        }
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + i), sum);
+    }
+#else
+    for (int i = 0; i < NnueHidden; i++)
+    {
+        int16_t sum = base[i];
+
+        for (int c = 0; c < addCount; c++)
+        {
+            sum = static_cast<int16_t>(sum + added[c][i]);
+        }
+
+        for (int c = 0; c < removeCount; c++)
+        {
+            sum = static_cast<int16_t>(sum - removed[c][i]);
+        }
+
+        out[i] = sum;
+    }
+#endif
+}
+
+// Clips one half of the accumulator to 0..127
+void clip(const int16_t* in, uint8_t* out) {
+#if defined(NNUE_AVX2)
+    const __m256i max = _mm256_set1_epi16(127);
+
+    for (int i = 0; i < NnueHidden; i += 32)
+    {
+        __m256i low = _mm256_min_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(in + i)), max);
+        __m256i high = _mm256_min_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(in + i + 16)), max);
+
+        // Packing saturates negatives to 0 but interleaves the 128-bit lanes, which the permute undoes
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+#elif defined(NNUE_SSE2)
+    const __m128i max = _mm_set1_epi16(127);
+
+    for (int i = 0; i < NnueHidden; i += 16)
+    {
+        __m128i low = _mm_min_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(in + i)), max);
+        __m128i high = _mm_min_epi16(_mm_load_si128(reinterpret_cast<const __m128i*>(in + i + 8)), max);
+
+        _mm_store_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+    }
+#else
+    for (int i = 0; i < NnueHidden; i++)
+    {
+        out[i] = static_cast<uint8_t>(std::clamp<int>(in[i], 0, 127));
+    }
+#endif
+}
+
+// Dot product of clipped activations and int8 weights; size is a multiple of 32.
+// Pairs of products cannot saturate the int16 sums of maddubs, as 2 * 127 * 128 < 32768.
+int32_t dot(const uint8_t* input, const int8_t* weights, int size) {
+#if defined(NNUE_AVX2)
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+
+    for (int i = 0; i < size; i += 32)
+    {
+        __m256i products = _mm256_maddubs_epi16(_mm256_load_si256(reinterpret_cast<const __m256i*>(input + i)),
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+
+    __m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#elif defined(NNUE_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = _mm_setzero_si128();
+
+    for (int i = 0; i < size; i += 16)
+    {
+        __m128i in = _mm_load_si128(reinterpret_cast<const __m128i*>(input + i));
+        __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(weights + i));
+
+        // Widen to int16: zero-extend the activations, sign-extend the weights
+        __m128i inLow = _mm_unpacklo_epi8(in, zero);
+        __m128i inHigh = _mm_unpackhi_epi8(in, zero);
+        __m128i wLow = _mm_srai_epi16(_mm_unpacklo_epi8(w, w), 8);
+        __m128i wHigh = _mm_srai_epi16(_mm_unpackhi_epi8(w, w), 8);
+
+        total = _mm_add_epi32(total, _mm_madd_epi16(inLow, wLow));
+        total = _mm_add_epi32(total, _mm_madd_epi16(inHigh, wHigh));
+    }
+#endif
+
+#if defined(NNUE_AVX2) || defined(NNUE_SSE2)
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0x4E));
+    total = _mm_add_epi32(total, _mm_shuffle_epi32(total, 0xB1));
+
+    return _mm_cvtsi128_si32(total);
+#else
+    int32_t total = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        total += input[i] * weights[i];
+    }
+
+    return total;
+#endif
+}
+
+}
+
+Nnue::Nnue() = default;
+Nnue::~Nnue() = default;
+
+void Nnue::clear() {
+    weights.reset();
+    generation++;
+}
+
+// The files are little-endian like every machine the game is built for, so arrays are read as they are
+bool Nnue::load(const std::string& path) {
+    weights.reset();
+    generation++;
+
+    std::ifstream in(path, std::ios::binary);
+    char magic[4];
+    uint32_t sizes[3];
+
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, "CNN1", 4) != 0
+        || !in.read(reinterpret_cast<char*>(sizes), sizeof(sizes))
+        || sizes[0] != NnueInputs || sizes[1] != NnueHidden || sizes[2] != NnueLayer1)
+    {
+        return false;
+    }
+
+    auto loaded = std::make_unique<Weights>();
+
+    auto read = [&in](auto& array) {
+        in.read(reinterpret_cast<char*>(&array), sizeof(array));
+    };
+
+    read(loaded->featureBias);
+    read(loaded->featureWeights);
+    read(loaded->hiddenBias);
+    read(loaded->hiddenWeights);
+    read(loaded->outputBias);
+    read(loaded->outputWeights);
+
+    // A truncated file or one with more after the output layer is a different network
+    if (!in || in.peek() != std::ifstream::traits_type::eof())
+    {
+        return false;
+    }
+
+    weights = std::move(loaded);
+    return true;
+}
+
+void Nnue::refresh(const Position& pos, NnueAccumulator& accumulator) const {
+    for (ComandColor perspective : { ComandColor::White, ComandColor::Black })
+    {
+        const int16_t* columns[SquareCount];
+        int count = 0;
+        Bitboard occupied = pos.pieces();
+
+        while (occupied)
+        {
+            int square = popLsb(occupied);
+            columns[count++] = weights->featureWeights[featureIndex(perspective, pos.colorOn(square), pos.pieceOn(square), square)];
+        }
+
+        accumulate(weights->featureBias, accumulator.values[static_cast<int>(perspective)], columns, count, nullptr, 0);
+    }
+}
+
+// A move takes the moved piece off its square and puts it (or what it promotes to)
+// on the target, removes a captured piece and moves the rook when castling
+void Nnue::update(const StateInfo& st, ComandColor us, const NnueAccumulator& before, NnueAccumulator& after) const {
+    struct Change {
+        ComandColor color;
+        PieceType type;
+        int square;
+    };
+
+    Move move = st.move;
+    ComandColor them = opponent(us);
+    Change added[2], removed[2];
+    int addCount = 0, removeCount = 0;
+
+    removed[removeCount++] = { us, st.moved, move.from() };
+    added[addCount++] = { us, move.isPromotion() ? move.promotionType() : st.moved, move.to() };
+
+    if (move.flags() == Move::EnPassant)
+    {
+        removed[removeCount++] = { them, PieceType::Pawn, move.to() + (us == ComandColor::White ? -8 : 8) };
+    }
+    else if (move.isCapture())
+    {
+        removed[removeCount++] = { them, st.captured, move.to() };
+    }
+    else if (move.flags() == Move::KingCastle)
+    {
+        removed[removeCount++] = { us, PieceType::Rook, move.to() + 1 };
+        added[addCount++] = { us, PieceType::Rook, move.to() - 1 };
+    }
+    else if (move.flags() == Move::QueenCastle)
+    {
+        removed[removeCount++] = { us, PieceType::Rook, move.to() - 2 };
+        added[addCount++] = { us, PieceType::Rook, move.to() + 1 };
+    }
+
+    for (ComandColor perspective : { ComandColor::White, ComandColor::Black })
+    {
+        const int16_t* addedColumns[2];
+        const int16_t* removedColumns[2];
+
+        for (int i = 0; i < addCount; i++)
+        {
+            addedColumns[i] = weights->featureWeights[featureIndex(perspective, added[i].color, added[i].type, added[i].square)];
+        }
+
+        for (int i = 0; i < removeCount; i++)
+        {
+            removedColumns[i] = weights->featureWeights[featureIndex(perspective, removed[i].color, removed[i].type, removed[i].square)];
+        }
+
+        int side = static_cast<int>(perspective);
+        accumulate(before.values[side], after.values[side], addedColumns, addCount, removedColumns, removeCount);
+    }
+}
+
+int Nnue::output(const NnueAccumulator& accumulator, ComandColor us) const {
+    alignas(32) uint8_t input[2 * NnueHidden];
+    alignas(32) uint8_t hidden[NnueLayer1];
+
+    clip(accumulator.values[static_cast<int>(us)], input);
+    clip(accumulator.values[static_cast<int>(opponent(us))], input + NnueHidden);
+
+    for (int i = 0; i < NnueLayer1; i++)
+    {
+        int32_t sum = weights->hiddenBias[i] + dot(input, weights->hiddenWeights[i], 2 * NnueHidden);
+        hidden[i] = static_cast<uint8_t>(std::clamp(sum >> 6, 0, 127));
+    }
+
+    int32_t sum = weights->outputBias + dot(hidden, weights->outputWeights, NnueLayer1);
+
+    return static_cast<int>(static_cast<int64_t>(sum) * NnueOutputScale / (127 * 64));
+}
+
+int Nnue::evaluate(const Position& pos, NnueAccumulators& accumulators) const {
+    auto& entries = accumulators.entries;
+    int height = pos.movesPlayed();
+
+    // First layer sums of another network are of no use
+    if (accumulators.generation != generation)
+    {
+        entries.clear();
+        accumulators.generation = generation;
+    }
+
+    if (static_cast<int>(entries.size()) <= height)
+    {
+        entries.resize(height + 1);
+    }
+
+    // Hash key of the position after index moves
+    auto keyAt = [&pos, height](int index) {
+        return index == height ? pos.key() : pos.playedState(index).key;
+    };
+
+    // Go back to the nearest ply whose accumulator still belongs to this line
+    int start = height;
+
+    while (start >= 0 && !(entries[start].computed && entries[start].key == keyAt(start)))
+    {
+        start--;
+    }
+
+    if (start < 0)
+    {
+        start = height;
+        refresh(pos, entries[height].accumulator);
+        entries[height].key = pos.key();
+        entries[height].computed = true;
+    }
+
+    for (int index = start; index < height; index++)
+    {
+        // The side to move played the moves an even number of plies back
+        ComandColor us = ((height - index) % 2 == 0) ? pos.sideToMove() : opponent(pos.sideToMove());
+
+        update(pos.playedState(index), us, entries[index].accumulator, entries[index + 1].accumulator);
+        entries[index + 1].key = keyAt(index + 1);
+        entries[index + 1].computed = true;
+    }
+
+    return output(entries[height].accumulator, pos.sideToMove());
+}
+
+int Nnue::evaluate(const Position& pos) const {
+    NnueAccumulator accumulator;
+    refresh(pos, accumulator);
+
+    return output(accumulator, pos.sideToMove());
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Position.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Efficiently updatable neural network evaluation. Every piece on a square is
+// one of 768 input features, seen from both sides: the first layer sums the
+// weight columns of the features present into 256 values per side, and that
+// accumulator only needs a few columns added or subtracted after a move. The
+// side to move's half and the other half are clipped to 0..127, go through a
+// 512x32 layer with int8 weights, are clipped again and summed by the output
+// neuron.
+//
+// Quantization: the first layer is int16 with activations scaled by 127, the
+// hidden and output layers have int8 weights scaled by 64 and int32 biases,
+// and the output is in units of NnueOutputScale centipawns / (127 * 64).
+//
+// The kernels use AVX2 when built with it (-mavx2, /arch:AVX2), else SSE2
+// on x86-64, else plain loops.
+
+constexpr int NnueInputs = 768;
+constexpr int NnueHidden = 256;
+constexpr int NnueLayer1 = 32;
+constexpr int NnueOutputScale = 400;
+
+// First layer sums of one position, white's view first
+struct alignas(32) NnueAccumulator {
+    int16_t values[2][NnueHidden];
+};
+
+// Accumulators of the positions along the line a thread is searching, by
+// number of moves played. An entry is reused while its hash key matches the
+// position at that height, so nothing has to be invalidated on unmakeMove.
+// All of them are dropped once a different network is loaded.
+class NnueAccumulators {
+private:
+    struct Entry {
+        uint64_t key = 0;
+        bool computed = false;
+        NnueAccumulator accumulator;
+    };
+
+    std::vector<Entry> entries;
+    uint32_t generation = 0;
+
+    friend class Nnue;
+};
+
+class Nnue {
+private:
+    struct Weights;
+
+    std::unique_ptr<Weights> weights;
+
+    // Counts the networks loaded or cleared, so accumulators of an earlier one are noticed
+    uint32_t generation = 0;
+
+    void refresh(const Position& pos, NnueAccumulator& accumulator) const;
+    void update(const StateInfo& st, ComandColor us, const NnueAccumulator& before, NnueAccumulator& after) const;
+    int output(const NnueAccumulator& accumulator, ComandColor us) const;
+
+public:
+    Nnue();
+    ~Nnue();
+
+    // Reads a network written as "CNN1", the three layer sizes as uint32 and
+    // then the first layer biases and weights, the hidden layer biases and
+    // weights and the output bias and weights, all little-endian. Returns
+    // false and keeps no network if the file is missing or does not match.
+    bool load(const std::string& path);
+
+    void clear();
+
+    bool isLoaded() const {
+        return weights != nullptr;
+    }
+
+    // Score from the side to move's view; the accumulators of earlier plies
+    // are updated incrementally up to the current position
+    int evaluate(const Position& pos, NnueAccumulators& accumulators) const;
+
+    // Same, recomputing the accumulator from scratch
+    int evaluate(const Position& pos) const;
+};
+
+extern Nnue nnue;
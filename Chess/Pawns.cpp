@@ -0,0 +1,179 @@
+#include "Pawns.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr TaperedScore Doubled = { -10, -25 };
+constexpr TaperedScore Isolated = { -8, -12 };
+constexpr TaperedScore Backward = { -8, -10 };
+
+// By rank counted from the pawn's own side
+constexpr TaperedScore Passed[8] = { { 0, 0 }, { 2, 8 }, { 5, 12 }, { 10, 25 }, { 25, 50 }, { 45, 90 }, { 75, 140 }, { 0, 0 } };
+
+// For the king's file and each file beside it, by how far the nearest own pawn
+// stands in front of the king: one rank, two ranks, further away or none
+constexpr int ShelterPenalty[3] = { 0, -12, -30 };
+
+Bitboard fileBB(int file) {
+    return FileABB << file;
+}
+
+Bitboard rankBB(int rank) {
+    return Rank1BB << (8 * rank);
+}
+
+Bitboard adjacentFiles(int file) {
+    return (file > 0 ? fileBB(file - 1) : 0) | (file < 7 ? fileBB(file + 1) : 0);
+}
+
+// The ranks in front of the square as seen from the color's side
+Bitboard forwardRanks(ComandColor color, int square) {
+    int rank = rankOf(square);
+
+    if (color == ComandColor::White)
+    {
+        return rank == 7 ? 0 : ~0ULL << (8 * (rank + 1));
+    }
+
+    return rank == 0 ? 0 : ~0ULL >> (8 * (8 - rank));
+}
+
+TaperedScore evaluateStructure(const Position& pos, ComandColor us) {
+    ComandColor them = opponent(us);
+    Bitboard ours = pos.pieces(us, PieceType::Pawn);
+    Bitboard theirs = pos.pieces(them, PieceType::Pawn);
+    Bitboard pawns = ours;
+    TaperedScore score;
+
+    while (pawns)
+    {
+        int square = popLsb(pawns);
+        int file = fileOf(square);
+        Bitboard ahead = forwardRanks(us, square);
+        bool frontmost = !(ours & fileBB(file) & ahead);
+
+        // Only the pawns behind another are counted, so two pawns on a file cost one penalty
+        if (!frontmost)
+        {
+            score += Doubled;
+        }
+
+        // Isolated without own pawns on the files beside it; backward if those have all
+        // advanced past it and an enemy pawn guards the square in front of it
+        if (!(ours & adjacentFiles(file)))
+        {
+            score += Isolated;
+        }
+        else if (!(ours & adjacentFiles(file) & ~ahead)
+            && (pawnAttacks(us, square + (us == ComandColor::White ? 8 : -8)) & theirs))
+        {
+            score += Backward;
+        }
+
+        if (frontmost && !(theirs & (fileBB(file) | adjacentFiles(file)) & ahead))
+        {
+            score += Passed[us == ComandColor::White ? rankOf(square) : 7 - rankOf(square)];
+        }
+    }
+
+    return score;
+}
+
+int shelter(const Position& pos, ComandColor us, int kingSquare) {
+    Bitboard ours = pos.pieces(us, PieceType::Pawn);
+    int center = std::clamp(fileOf(kingSquare), 1, 6);
+    int penalty = 0;
+
+    for (int file = center - 1; file <= center + 1; file++)
+    {
+        int nearest = 3;
+
+        for (int distance = 2; distance >= 1; distance--)
+        {
+            int rank = rankOf(kingSquare) + (us == ComandColor::White ? distance : -distance);
+
+            if (rank >= 0 && rank <= 7 && (ours & fileBB(file) & rankBB(rank)))
+            {
+                nearest = distance;
+            }
+        }
+
+        penalty += ShelterPenalty[nearest - 1];
+    }
+
+    return penalty;
+}
+
+}
+
+void PawnTable::resize(size_t sizeMB) {
+    sizeMB = std::max<size_t>(sizeMB, 1);
+
+    if (entries && sizeMB == megabytes)
+    {
+        return;
+    }
+
+    // A power of two, so the index is the low bits of the key
+    megabytes = sizeMB;
+    entryCount = 1;
+
+    while (entryCount * 2 * sizeof(PawnEntry) <= megabytes * 1024 * 1024)
+    {
+        entryCount *= 2;
+    }
+
+    entries = std::make_unique<PawnEntry[]>(entryCount);
+    clear();
+}
+
+// An empty entry has key 0, which is also the key without pawns, and a score of 0, which is right for it
+void PawnTable::clear() {
+    std::fill(entries.get(), entries.get() + entryCount, PawnEntry());
+
+    probeCount.store(0, std::memory_order_relaxed);
+    hitCount.store(0, std::memory_order_relaxed);
+}
+
+// Only the owning thread writes the counters, so a load and a store are enough
+PawnEntry& PawnTable::probe(const Position& pos) {
+    uint64_t key = pos.pawnKey();
+    PawnEntry& entry = entries[key & (entryCount - 1)];
+
+    probeCount.store(probeCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (entry.key == key)
+    {
+        hitCount.store(hitCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return entry;
+    }
+
+    entry.key = key;
+    entry.score = evaluateStructure(pos, ComandColor::White);
+    entry.score -= evaluateStructure(pos, ComandColor::Black);
+    entry.kingSquare[0] = entry.kingSquare[1] = SquareNone;
+
+    return entry;
+}
+
+TaperedScore evaluatePawns(const Position& pos, PawnTable& table) {
+    PawnEntry& entry = table.probe(pos);
+
+    for (ComandColor color : { ComandColor::White, ComandColor::Black })
+    {
+        int side = static_cast<int>(color);
+        int king = pos.kingSquare(color);
+
+        if (entry.kingSquare[side] != king)
+        {
+            entry.kingSquare[side] = king;
+            entry.shelter[side] = shelter(pos, color, king);
+        }
+    }
+
+    TaperedScore score = entry.score;
+    score.mg += entry.shelter[0] - entry.shelter[1];
+
+    return score;
+}
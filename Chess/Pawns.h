@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Position.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+constexpr int DefaultPawnHashMB = 1;
+
+// Pawn structure terms of one position, white's minus black's. The king
+// shelters depend on where the kings stand as well, so they are kept for the
+// king squares they were last computed for and redone when a king moves.
+struct PawnEntry {
+    uint64_t key = 0;
+    TaperedScore score;
+    int kingSquare[2] = { SquareNone, SquareNone };
+    int shelter[2] = { 0, 0 };
+};
+
+// Cache of pawn structure evaluations by pawn key. Pawns change far less often
+// than the rest of the position, so nearly every probe is a hit. Each search
+// thread has its own table, which therefore needs no synchronization; only
+// the counters are atomic so other threads can read them.
+class PawnTable {
+private:
+    std::unique_ptr<PawnEntry[]> entries;
+    size_t entryCount = 0;
+    size_t megabytes = 0;
+
+    std::atomic<uint64_t> probeCount{ 0 };
+    std::atomic<uint64_t> hitCount{ 0 };
+
+public:
+    PawnTable() {
+        resize(DefaultPawnHashMB);
+    }
+
+    // Reallocates the table if the size differs, dropping every entry
+    void resize(size_t sizeMB);
+
+    void clear();
+
+    size_t sizeMB() const {
+        return megabytes;
+    }
+
+    // Entry for the position's pawns, evaluated on a miss
+    PawnEntry& probe(const Position& pos);
+
+    uint64_t probes() const {
+        return probeCount.load(std::memory_order_relaxed);
+    }
+
+    uint64_t hits() const {
+        return hitCount.load(std::memory_order_relaxed);
+    }
+};
+
+// Doubled, isolated, backward and passed pawns plus king shelter, white's minus black's
+TaperedScore evaluatePawns(const Position& pos, PawnTable& table);
@@ -0,0 +1,533 @@
+#include "Pgn.h"
+
+#include "MoveGen.h"
+
+namespace {
+
+const char pieceLetters[6] = { 'P', 'N', 'B', 'R', 'Q', 'K' };
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Characters that end a movetext token
+bool isDelimiter(char c) {
+    return isSpace(c) || c == '{' || c == '}' || c == '(' || c == ')' || c == ';' || c == '[' || c == ']';
+}
+
+bool isResult(std::string_view token) {
+    return token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*";
+}
+
+PieceType pieceFromLetter(char c) {
+    for (int type = 1; type < 6; type++)
+    {
+        if (pieceLetters[type] == c)
+        {
+            return static_cast<PieceType>(type);
+        }
+    }
+
+    return PieceType::None;
+}
+
+std::string squareName(int square) {
+    return { static_cast<char>('a' + fileOf(square)), static_cast<char>('1' + rankOf(square)) };
+}
+
+// [Name "Value"] with \ and " escaped, the way readTag expects them
+void writeTag(std::ostream& out, const std::string& name, const std::string& value) {
+    out << '[' << name << " \"";
+
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+        {
+            out << '\\';
+        }
+
+        out << c;
+    }
+
+    out << "\"]\n";
+}
+
+}
+
+std::string toSan(Position& pos, Move move) {
+    std::string san;
+
+    if (move.isCastle())
+    {
+        san = (move.flags() == Move::KingCastle) ? "O-O" : "O-O-O";
+    }
+    else
+    {
+        int from = move.from();
+        int to = move.to();
+        PieceType piece = pos.pieceOn(from);
+
+        if (piece == PieceType::Pawn)
+        {
+            if (move.isCapture())
+            {
+                san += static_cast<char>('a' + fileOf(from));
+                san += 'x';
+            }
+
+            san += squareName(to);
+
+            if (move.isPromotion())
+            {
+                san += '=';
+                san += pieceLetters[static_cast<int>(move.promotionType())];
+            }
+        }
+        else
+        {
+            san += pieceLetters[static_cast<int>(piece)];
+
+            // Name the file, else the rank, else both if another piece of the kind can go there too
+            MoveList moves;
+            generateMoves(pos, moves, pos.pieces(pos.sideToMove(), piece) & ~squareBB(from));
+
+            bool ambiguous = false, sameFile = false, sameRank = false;
+
+            for (Move other : moves)
+            {
+                if (other.to() == to)
+                {
+                    ambiguous = true;
+                    sameFile |= fileOf(other.from()) == fileOf(from);
+                    sameRank |= rankOf(other.from()) == rankOf(from);
+                }
+            }
+
+            if (ambiguous)
+            {
+                if (!sameFile)
+                {
+                    san += static_cast<char>('a' + fileOf(from));
+                }
+                else if (!sameRank)
+                {
+                    san += static_cast<char>('1' + rankOf(from));
+                }
+                else
+                {
+                    san += squareName(from);
+                }
+            }
+
+            if (move.isCapture())
+            {
+                san += 'x';
+            }
+
+            san += squareName(to);
+        }
+    }
+
+    pos.makeMove(move);
+
+    if (pos.inCheck())
+    {
+        MoveList replies;
+        generateMoves(pos, replies);
+        san += replies.empty() ? '#' : '+';
+    }
+
+    pos.unmakeMove();
+
+    return san;
+}
+
+Move parseSan(const Position& pos, std::string_view san) {
+    // Check, mate and annotation marks carry no information about the move
+    while (!san.empty() && (san.back() == '+' || san.back() == '#' || san.back() == '!' || san.back() == '?'))
+    {
+        san.remove_suffix(1);
+    }
+
+    // Only moves of the named piece type are generated
+    MoveList moves;
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+    {
+        int flag = (san.size() == 3) ? Move::KingCastle : Move::QueenCastle;
+        generateMoves(pos, moves, pos.pieces(pos.sideToMove(), PieceType::King));
+
+        for (Move move : moves)
+        {
+            if (move.flags() == flag)
+            {
+                return move;
+            }
+        }
+
+        return Move::none();
+    }
+
+    PieceType piece = PieceType::Pawn;
+    PieceType promotion = PieceType::None;
+
+    if (!san.empty() && pieceFromLetter(san.front()) != PieceType::None)
+    {
+        piece = pieceFromLetter(san.front());
+        san.remove_prefix(1);
+    }
+
+    // Promotion written as "e8=Q" or "e8Q"
+    if (piece == PieceType::Pawn && san.size() >= 3 && pieceFromLetter(san.back()) != PieceType::None)
+    {
+        promotion = pieceFromLetter(san.back());
+        san.remove_suffix(san[san.size() - 2] == '=' ? 2 : 1);
+    }
+
+    if (san.size() < 2)
+    {
+        return Move::none();
+    }
+
+    char toFile = san[san.size() - 2];
+    char toRank = san[san.size() - 1];
+
+    if (toFile < 'a' || toFile > 'h' || toRank < '1' || toRank > '8')
+    {
+        return Move::none();
+    }
+
+    generateMoves(pos, moves, pos.pieces(pos.sideToMove(), piece));
+
+    int to = makeSquare(toFile - 'a', toRank - '1');
+    int fromFile = -1;
+    int fromRank = -1;
+
+    for (char c : san.substr(0, san.size() - 2))
+    {
+        if (c >= 'a' && c <= 'h') fromFile = c - 'a';
+        else if (c >= '1' && c <= '8') fromRank = c - '1';
+        else if (c != 'x' && c != '-') return Move::none();
+    }
+
+    Move found = Move::none();
+
+    for (Move move : moves)
+    {
+        if (move.to() != to || move.isCastle() || pos.pieceOn(move.from()) != piece
+            || (fromFile >= 0 && fileOf(move.from()) != fromFile)
+            || (fromRank >= 0 && rankOf(move.from()) != fromRank)
+            || move.isPromotion() != (promotion != PieceType::None)
+            || (move.isPromotion() && move.promotionType() != promotion))
+        {
+            continue;
+        }
+
+        if (found != Move::none())
+        {
+            return Move::none();
+        }
+
+        found = move;
+    }
+
+    return found;
+}
+
+std::string gameResult(const Position& pos) {
+    MoveList moves;
+    generateMoves(pos, moves);
+
+    if (moves.empty())
+    {
+        if (!pos.inCheck())
+        {
+            return "1/2-1/2";
+        }
+
+        return (pos.sideToMove() == ComandColor::White) ? "0-1" : "1-0";
+    }
+
+    return (pos.halfmoves() >= 100) ? "1/2-1/2" : "*";
+}
+
+std::string_view PgnGame::tag(std::string_view name) const {
+    for (const auto& t : tags)
+    {
+        if (t.name == name)
+        {
+            return t.value;
+        }
+    }
+
+    return {};
+}
+
+void PgnReader::skipLine() {
+    while (cursor < text.size() && text[cursor] != '\n')
+    {
+        cursor++;
+    }
+}
+
+void PgnReader::skipComment() {
+    size_t end = text.find('}', cursor);
+    cursor = (end == std::string_view::npos) ? text.size() : end + 1;
+}
+
+// Variations nest and may contain comments with parentheses in them
+void PgnReader::skipVariation() {
+    int depth = 0;
+
+    while (cursor < text.size())
+    {
+        char c = text[cursor];
+
+        if (c == '{')
+        {
+            skipComment();
+            continue;
+        }
+
+        cursor++;
+
+        if (c == '(')
+        {
+            depth++;
+        }
+        else if (c == ')' && --depth == 0)
+        {
+            return;
+        }
+    }
+}
+
+// [Name "Value"], with \" and \\ allowed inside the value. The value view keeps the escapes.
+bool PgnReader::readTag(PgnGame& game) {
+    cursor++;
+
+    size_t nameStart = cursor;
+
+    while (cursor < text.size() && !isSpace(text[cursor]) && text[cursor] != ']' && text[cursor] != '"')
+    {
+        cursor++;
+    }
+
+    PgnTag tag;
+    tag.name = text.substr(nameStart, cursor - nameStart);
+
+    size_t quote = text.find('"', cursor);
+    size_t lineEnd = text.find('\n', cursor);
+
+    if (quote != std::string_view::npos && quote < lineEnd)
+    {
+        size_t valueStart = quote + 1;
+        cursor = valueStart;
+
+        while (cursor < text.size() && text[cursor] != '"')
+        {
+            cursor += (text[cursor] == '\\' && cursor + 1 < text.size()) ? 2 : 1;
+        }
+
+        tag.value = text.substr(valueStart, std::min(cursor, text.size()) - valueStart);
+    }
+
+    skipLine();
+
+    if (tag.name.empty())
+    {
+        return false;
+    }
+
+    game.tags.push_back(tag);
+    return true;
+}
+
+bool PgnReader::next(PgnGame& game) {
+    game.clear();
+
+    bool started = false;
+    bool inMovetext = false;
+
+    while (cursor < text.size())
+    {
+        char c = text[cursor];
+
+        if (isSpace(c))
+        {
+            cursor++;
+            continue;
+        }
+
+        if (!started)
+        {
+            started = true;
+            game.offset = base + cursor;
+        }
+
+        // Escape lines start with % in the first column
+        if (c == '%' && (cursor == 0 || text[cursor - 1] == '\n'))
+        {
+            skipLine();
+        }
+        else if (c == '[')
+        {
+            // Tags after movetext belong to the next game, this one has no result
+            if (inMovetext)
+            {
+                return true;
+            }
+
+            readTag(game);
+        }
+        else if (c == '{')
+        {
+            skipComment();
+        }
+        else if (c == ';')
+        {
+            skipLine();
+        }
+        else if (c == '(')
+        {
+            skipVariation();
+        }
+        else if (c == ')' || c == ']' || c == '}')
+        {
+            cursor++;
+        }
+        else
+        {
+            inMovetext = true;
+
+            size_t start = cursor;
+
+            while (cursor < text.size() && !isDelimiter(text[cursor]))
+            {
+                cursor++;
+            }
+
+            std::string_view token = text.substr(start, cursor - start);
+
+            if (isResult(token))
+            {
+                game.result = token;
+                return true;
+            }
+
+            // NAGs such as $1
+            if (token.front() == '$')
+            {
+                continue;
+            }
+
+            // Move numbers, possibly glued to the move as in "1.e4" or "12...Nf6"
+            if (token.front() >= '1' && token.front() <= '9')
+            {
+                size_t digits = token.find_first_not_of("0123456789");
+
+                if (digits == std::string_view::npos || token[digits] != '.')
+                {
+                    continue;
+                }
+
+                token.remove_prefix(token.find_first_not_of('.', digits) == std::string_view::npos ? token.size() : token.find_first_not_of('.', digits));
+            }
+
+            if (!token.empty())
+            {
+                game.moves.push_back(token);
+            }
+        }
+    }
+
+    return started;
+}
+
+bool replayGame(const PgnGame& game, Position& pos, std::string& error,
+    const std::function<void(const Position&, Move)>& onMove) {
+    std::string_view fen = game.tag("FEN");
+
+    if (!pos.setFen(fen.empty() ? std::string(StartFen) : std::string(fen)))
+    {
+        error = "invalid FEN tag \"" + std::string(fen) + "\"";
+        return false;
+    }
+
+    for (std::string_view san : game.moves)
+    {
+        Move move = parseSan(pos, san);
+
+        if (move == Move::none())
+        {
+            error = "illegal move " + std::to_string(pos.fullmoves())
+                + (pos.sideToMove() == ComandColor::White ? ". " : "... ") + std::string(san);
+            return false;
+        }
+
+        if (onMove)
+        {
+            onMove(pos, move);
+        }
+
+        pos.makeMove(move);
+    }
+
+    return true;
+}
+
+void writePgn(std::ostream& out, const PgnTags& tags, const std::string& startFen, const std::vector<Move>& moves, const std::string& result) {
+    bool hasFenTag = false;
+
+    for (const auto& [name, value] : tags)
+    {
+        writeTag(out, name, value);
+        hasFenTag |= name == "FEN";
+    }
+
+    if (startFen != StartFen && !hasFenTag)
+    {
+        writeTag(out, "SetUp", "1");
+        writeTag(out, "FEN", startFen);
+    }
+
+    out << '\n';
+
+    Position pos;
+    pos.setFen(startFen);
+
+    std::string line;
+
+    auto emit = [&out, &line](const std::string& token) {
+        if (!line.empty() && line.size() + 1 + token.size() > 80)
+        {
+            out << line << '\n';
+            line.clear();
+        }
+
+        if (!line.empty())
+        {
+            line += ' ';
+        }
+
+        line += token;
+    };
+
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        if (pos.sideToMove() == ComandColor::White)
+        {
+            emit(std::to_string(pos.fullmoves()) + ".");
+        }
+        else if (i == 0)
+        {
+            emit(std::to_string(pos.fullmoves()) + "...");
+        }
+
+        emit(toSan(pos, moves[i]));
+        pos.makeMove(moves[i]);
+    }
+
+    emit(result);
+    out << line << "\n\n";
+}
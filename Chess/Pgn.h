@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Position.h"
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Standard Algebraic Notation of a legal move, e.g. "Nbd7", "exd6", "O-O" or "e8=Q+".
+// The move is played and taken back to find check and mate, leaving pos as it was.
+std::string toSan(Position& pos, Move move);
+
+// The legal move written in SAN, or Move::none() if there is no such move or it is ambiguous
+Move parseSan(const Position& pos, std::string_view san);
+
+// "1-0", "0-1" or "1/2-1/2" if the game is over in the position, "*" otherwise
+std::string gameResult(const Position& pos);
+
+struct PgnTag {
+    std::string_view name;
+    std::string_view value;
+};
+
+// One game as views into the text it was read from
+struct PgnGame {
+    size_t offset = 0;
+    std::vector<PgnTag> tags;
+    std::vector<std::string_view> moves;
+    std::string_view result;
+
+    // Value of the tag, empty if the game does not have it
+    std::string_view tag(std::string_view name) const;
+
+    void clear() {
+        offset = 0;
+        tags.clear();
+        moves.clear();
+        result = {};
+    }
+};
+
+// Splits PGN text into games, one per call to next(). Nothing is copied:
+// a game's views point into the text, which has to outlive them. Move
+// numbers, comments, variations and NAGs are skipped, so moves holds only
+// the SAN of the main line. A game without a result (cut off at the end of
+// the text or by the next tag section) comes back with an empty result.
+class PgnReader {
+private:
+    std::string_view text;
+    size_t cursor = 0;
+    size_t base = 0;
+
+    void skipLine();
+    void skipComment();
+    void skipVariation();
+    bool readTag(PgnGame& game);
+
+public:
+    // baseOffset is added to game offsets, for text that is part of a larger file
+    explicit PgnReader(std::string_view pgnText, size_t baseOffset = 0)
+        : text(pgnText), base(baseOffset) {}
+
+    // Reads the next game, returns false at the end of the text
+    bool next(PgnGame& game);
+
+    // Offset of the next unread byte
+    size_t position() const {
+        return base + cursor;
+    }
+};
+
+// Sets pos to the start of the game (the FEN tag if there is one) and plays its
+// moves, calling onMove before each. Returns false with the reason in error if
+// the start position or a move is not valid; pos then stops where it went wrong.
+bool replayGame(const PgnGame& game, Position& pos, std::string& error,
+    const std::function<void(const Position&, Move)>& onMove = nullptr);
+
+using PgnTags = std::vector<std::pair<std::string, std::string>>;
+
+// Writes a game in export format: the tags in the given order (SetUp and FEN
+// are added when the game does not start from the initial position), then the
+// SAN movetext wrapped at 80 columns and the result
+void writePgn(std::ostream& out, const PgnTags& tags, const std::string& startFen, const std::vector<Move>& moves, const std::string& result);
@@ -0,0 +1,453 @@
+#include "Position.h"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace {
+
+// Filled at compile time from a fixed seed, so keys are identical across builds and runs
+constexpr ZobristKeys makeZobristKeys() {
+    ZobristKeys keys{};
+    uint64_t state = 1070372;
+
+    auto next = [&state]() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 2685821657736338717ULL;
+    };
+
+    for (auto& color : keys.pieces)
+    {
+        for (auto& type : color)
+        {
+            for (auto& key : type)
+            {
+                key = next();
+            }
+        }
+    }
+
+    for (auto& key : keys.castling) key = next();
+    for (auto& key : keys.enPassant) key = next();
+    keys.side = next();
+
+    return keys;
+}
+
+// Castling rights that survive a move touching the square
+int castlingMask(int square) {
+    switch (square)
+    {
+    case 0: return ~WhiteQueenside;
+    case 4: return ~(WhiteKingside | WhiteQueenside);
+    case 7: return ~WhiteKingside;
+    case 56: return ~BlackQueenside;
+    case 60: return ~(BlackKingside | BlackQueenside);
+    case 63: return ~BlackKingside;
+    default: return AllCastling;
+    }
+}
+
+}
+
+constexpr ZobristKeys zobristKeys = makeZobristKeys();
+
+void Position::clear() {
+    for (auto& bb : byColor) bb = 0;
+    for (auto& bb : byType) bb = 0;
+    for (auto& piece : board) piece = PieceType::None;
+    occupied = 0;
+
+    turn = ComandColor::White;
+    castlingRights = NoCastling;
+    epSquare = SquareNone;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    zobristKey = 0;
+    pawnZobristKey = 0;
+    psqScore = TaperedScore();
+    phaseValue = 0;
+
+    history.clear();
+}
+
+uint64_t Position::computeKey() const {
+    uint64_t key = 0;
+    Bitboard b = occupied;
+
+    while (b)
+    {
+        int square = popLsb(b);
+        key ^= zobristKeys.pieces[static_cast<int>(colorOn(square))][static_cast<int>(board[square])][square];
+    }
+
+    key ^= zobristKeys.castling[castlingRights];
+
+    if (epSquare != SquareNone)
+    {
+        key ^= zobristKeys.enPassant[fileOf(epSquare)];
+    }
+
+    if (turn == ComandColor::Black)
+    {
+        key ^= zobristKeys.side;
+    }
+
+    return key;
+}
+
+bool Position::setFen(const std::string& fen) {
+    const std::string pieceChars = "pnbrqk";
+
+    std::istringstream stream(fen);
+    std::string placement, side, castlingField, ep;
+
+    clear();
+
+    if (!(stream >> placement >> side >> castlingField >> ep))
+    {
+        return false;
+    }
+
+    int file = 0;
+    int rank = 7;
+
+    for (char c : placement)
+    {
+        if (c == '/')
+        {
+            if (file != 8 || rank == 0)
+            {
+                clear();
+                return false;
+            }
+
+            file = 0;
+            rank--;
+        }
+        else if (c >= '1' && c <= '8')
+        {
+            file += c - '0';
+        }
+        else
+        {
+            size_t type = pieceChars.find(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+
+            if (type == std::string::npos || file > 7)
+            {
+                clear();
+                return false;
+            }
+
+            ComandColor color = std::isupper(static_cast<unsigned char>(c)) ? ComandColor::White : ComandColor::Black;
+            putPiece(makeSquare(file, rank), color, static_cast<PieceType>(type));
+            file++;
+        }
+
+        if (file > 8)
+        {
+            clear();
+            return false;
+        }
+    }
+
+    if (file != 8 || rank != 0
+        || popCount(pieces(ComandColor::White, PieceType::King)) != 1
+        || popCount(pieces(ComandColor::Black, PieceType::King)) != 1
+        || (pieces(PieceType::Pawn) & (Rank1BB | Rank8BB))
+        || (side != "w" && side != "b"))
+    {
+        clear();
+        return false;
+    }
+
+    turn = (side == "w") ? ComandColor::White : ComandColor::Black;
+
+    // The side that just moved cannot have left its king in check; the search would capture it
+    if (isAttacked(kingSquare(opponent(turn)), turn))
+    {
+        clear();
+        return false;
+    }
+
+    for (char c : castlingField)
+    {
+        switch (c)
+        {
+        case 'K': castlingRights |= WhiteKingside; break;
+        case 'Q': castlingRights |= WhiteQueenside; break;
+        case 'k': castlingRights |= BlackKingside; break;
+        case 'q': castlingRights |= BlackQueenside; break;
+        case '-': break;
+        default:
+            clear();
+            return false;
+        }
+    }
+
+    // Drop rights whose king or rook is not at home
+    for (int square : { 0, 4, 7, 56, 60, 63 })
+    {
+        PieceType expected = (fileOf(square) == 4) ? PieceType::King : PieceType::Rook;
+        ComandColor owner = (rankOf(square) == 0) ? ComandColor::White : ComandColor::Black;
+
+        if (!(pieces(owner, expected) & squareBB(square)))
+        {
+            castlingRights &= castlingMask(square);
+        }
+    }
+
+    if (ep != "-")
+    {
+        if (ep.size() != 2 || ep[0] < 'a' || ep[0] > 'h' || ep[1] != (turn == ComandColor::White ? '6' : '3'))
+        {
+            clear();
+            return false;
+        }
+
+        epSquare = makeSquare(ep[0] - 'a', ep[1] - '1');
+
+        // The opponent's pawn has just passed over the square: it stands in front of it,
+        // and the square and the one the pawn came from are empty
+        int up = (turn == ComandColor::White) ? 8 : -8;
+
+        if (!(pieces(opponent(turn), PieceType::Pawn) & squareBB(epSquare - up))
+            || !isEmpty(epSquare) || !isEmpty(epSquare + up))
+        {
+            clear();
+            return false;
+        }
+
+        // Only keep it if a capture is possible, so equal positions hash equally
+        if (!(pawnAttacks(opponent(turn), epSquare) & pieces(turn, PieceType::Pawn)))
+        {
+            epSquare = SquareNone;
+        }
+    }
+
+    // The move counters are optional
+    int halfmoves = 0;
+    int fullmoves = 1;
+
+    if (stream >> halfmoves >> fullmoves)
+    {
+        halfmoveClock = halfmoves;
+        fullmoveNumber = fullmoves;
+    }
+
+    zobristKey = computeKey();
+
+    return true;
+}
+
+std::string Position::toFen() const {
+    const std::string pieceChars = "pnbrqk";
+    std::string fen;
+
+    for (int rank = 7; rank >= 0; rank--)
+    {
+        int empty = 0;
+
+        for (int file = 0; file < 8; file++)
+        {
+            int square = makeSquare(file, rank);
+
+            if (isEmpty(square))
+            {
+                empty++;
+                continue;
+            }
+
+            if (empty)
+            {
+                fen += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+
+            char c = pieceChars[static_cast<int>(board[square])];
+            fen += (colorOn(square) == ComandColor::White) ? static_cast<char>(std::toupper(c)) : c;
+        }
+
+        if (empty)
+        {
+            fen += static_cast<char>('0' + empty);
+        }
+
+        if (rank > 0)
+        {
+            fen += '/';
+        }
+    }
+
+    fen += (turn == ComandColor::White) ? " w " : " b ";
+
+    if (castlingRights & WhiteKingside) fen += 'K';
+    if (castlingRights & WhiteQueenside) fen += 'Q';
+    if (castlingRights & BlackKingside) fen += 'k';
+    if (castlingRights & BlackQueenside) fen += 'q';
+    if (castlingRights == NoCastling) fen += '-';
+
+    if (epSquare != SquareNone)
+    {
+        fen += ' ';
+        fen += static_cast<char>('a' + fileOf(epSquare));
+        fen += static_cast<char>('1' + rankOf(epSquare));
+    }
+    else
+    {
+        fen += " -";
+    }
+
+    fen += ' ' + std::to_string(halfmoveClock) + ' ' + std::to_string(fullmoveNumber);
+
+    return fen;
+}
+
+void Position::makeMove(Move move) {
+    int from = move.from();
+    int to = move.to();
+    int up = (turn == ComandColor::White) ? 8 : -8;
+    ComandColor them = opponent(turn);
+    PieceType moved = board[from];
+
+    history.push_back({ zobristKey, castlingRights, epSquare, halfmoveClock, moved, PieceType::None, move });
+    StateInfo& st = history.back();
+
+    if (epSquare != SquareNone)
+    {
+        zobristKey ^= zobristKeys.enPassant[fileOf(epSquare)];
+        epSquare = SquareNone;
+    }
+
+    halfmoveClock++;
+
+    if (move.flags() == Move::EnPassant)
+    {
+        st.captured = PieceType::Pawn;
+        removePiece(to - up);
+    }
+    else if (move.isCapture())
+    {
+        st.captured = board[to];
+        removePiece(to);
+    }
+
+    if (moved == PieceType::Pawn || move.isCapture())
+    {
+        halfmoveClock = 0;
+    }
+
+    movePiece(from, to);
+
+    if (move.flags() == Move::KingCastle)
+    {
+        movePiece(to + 1, to - 1);
+    }
+    else if (move.flags() == Move::QueenCastle)
+    {
+        movePiece(to - 2, to + 1);
+    }
+    else if (move.isPromotion())
+    {
+        removePiece(to);
+        putPiece(to, turn, move.promotionType());
+    }
+    else if (move.flags() == Move::DoublePush && (pawnAttacks(turn, from + up) & pieces(them, PieceType::Pawn)))
+    {
+        epSquare = from + up;
+        zobristKey ^= zobristKeys.enPassant[fileOf(epSquare)];
+    }
+
+    int rights = castlingRights & castlingMask(from) & castlingMask(to);
+
+    zobristKey ^= zobristKeys.castling[castlingRights] ^ zobristKeys.castling[rights];
+    castlingRights = rights;
+
+    if (turn == ComandColor::Black)
+    {
+        fullmoveNumber++;
+    }
+
+    turn = them;
+    zobristKey ^= zobristKeys.side;
+}
+
+void Position::unmakeMove() {
+    const StateInfo& st = history.back();
+    Move move = st.move;
+    int from = move.from();
+    int to = move.to();
+
+    turn = opponent(turn);
+
+    int up = (turn == ComandColor::White) ? 8 : -8;
+
+    if (move.isPromotion())
+    {
+        removePiece(to);
+        putPiece(to, turn, PieceType::Pawn);
+    }
+    else if (move.flags() == Move::KingCastle)
+    {
+        movePiece(to - 1, to + 1);
+    }
+    else if (move.flags() == Move::QueenCastle)
+    {
+        movePiece(to + 1, to - 2);
+    }
+
+    movePiece(to, from);
+
+    if (move.flags() == Move::EnPassant)
+    {
+        putPiece(to - up, opponent(turn), PieceType::Pawn);
+    }
+    else if (move.isCapture())
+    {
+        putPiece(to, opponent(turn), st.captured);
+    }
+
+    if (turn == ComandColor::Black)
+    {
+        fullmoveNumber--;
+    }
+
+    zobristKey = st.key;
+    castlingRights = st.castlingRights;
+    epSquare = st.epSquare;
+    halfmoveClock = st.halfmoveClock;
+
+    history.pop_back();
+}
+
+bool Position::isDraw() const {
+    if (halfmoveClock >= 100)
+    {
+        return true;
+    }
+
+    // history[i].key is the position after i moves; only the same side to move can repeat
+    int last = static_cast<int>(history.size());
+    int stop = std::max(last - halfmoveClock, 0);
+
+    for (int i = last - 2; i >= stop; i -= 2)
+    {
+        if (history[i].key == zobristKey)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Bitboard Position::attackersTo(int square, Bitboard occupancy) const {
+    return (pawnAttacks(ComandColor::Black, square) & pieces(ComandColor::White, PieceType::Pawn))
+        | (pawnAttacks(ComandColor::White, square) & pieces(ComandColor::Black, PieceType::Pawn))
+        | (knightAttacks(square) & pieces(PieceType::Knight))
+        | (bishopAttacks(square, occupancy) & (pieces(PieceType::Bishop) | pieces(PieceType::Queen)))
+        | (rookAttacks(square, occupancy) & (pieces(PieceType::Rook) | pieces(PieceType::Queen)))
+        | (kingAttacks(square) & pieces(PieceType::King));
+}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include "Bitboard.h"
+#include "Move.h"
+#include "Psqt.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+enum CastlingRight {
+    NoCastling = 0,
+    WhiteKingside = 1,
+    WhiteQueenside = 2,
+    BlackKingside = 4,
+    BlackQueenside = 8,
+    AllCastling = 15
+};
+
+constexpr const char* StartFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Random keys XORed together into the position hash
+struct ZobristKeys {
+    uint64_t pieces[2][6][SquareCount];
+    uint64_t castling[16];
+    uint64_t enPassant[8];
+    uint64_t side;
+};
+
+extern const ZobristKeys zobristKeys;
+
+// What makeMove overwrites, kept so unmakeMove can restore it
+struct StateInfo {
+    uint64_t key;
+    int castlingRights;
+    int epSquare;
+    int halfmoveClock;
+    PieceType moved;
+    PieceType captured;
+    Move move;
+};
+
+// Occupancy of the board as bitboards per color and per piece type,
+// plus a mailbox so the piece on a square can be found without a scan,
+// and the rest of the game state needed to generate moves.
+class Position {
+private:
+    Bitboard byColor[2]{};
+    Bitboard byType[6]{};
+    Bitboard occupied = 0;
+    PieceType board[SquareCount];
+
+    ComandColor turn = ComandColor::White;
+    int castlingRights = NoCastling;
+    int epSquare = SquareNone;
+    int halfmoveClock = 0;
+    int fullmoveNumber = 1;
+    uint64_t zobristKey = 0;
+    uint64_t pawnZobristKey = 0;
+
+    // Sums of psqt over the pieces and of their phase weights, kept like the key
+    TaperedScore psqScore;
+    int phaseValue = 0;
+
+    std::vector<StateInfo> history;
+
+public:
+    Position() {
+        history.reserve(256);
+        clear();
+    }
+
+    void clear();
+
+    // Sets up the position from Forsyth-Edwards Notation, returns false
+    // (leaving an empty board) if the string is malformed
+    bool setFen(const std::string& fen);
+
+    // Forsyth-Edwards Notation of the position; the en passant square is
+    // only written when a capture on it is possible
+    std::string toFen() const;
+
+    void putPiece(int square, ComandColor color, PieceType type) {
+        Bitboard bb = squareBB(square);
+
+        byColor[static_cast<int>(color)] |= bb;
+        byType[static_cast<int>(type)] |= bb;
+        occupied |= bb;
+        board[square] = type;
+        zobristKey ^= zobristKeys.pieces[static_cast<int>(color)][static_cast<int>(type)][square];
+        psqScore += psqt.scores[static_cast<int>(color)][static_cast<int>(type)][square];
+        phaseValue += PhaseWeight[static_cast<int>(type)];
+
+        if (type == PieceType::Pawn)
+        {
+            pawnZobristKey ^= zobristKeys.pieces[static_cast<int>(color)][static_cast<int>(type)][square];
+        }
+    }
+
+    void removePiece(int square) {
+        Bitboard bb = squareBB(square);
+        int color = (byColor[0] & bb) ? 0 : 1;
+        int type = static_cast<int>(board[square]);
+
+        byColor[color] &= ~bb;
+        byType[type] &= ~bb;
+        occupied &= ~bb;
+        board[square] = PieceType::None;
+        zobristKey ^= zobristKeys.pieces[color][type][square];
+        psqScore -= psqt.scores[color][type][square];
+        phaseValue -= PhaseWeight[type];
+
+        if (type == static_cast<int>(PieceType::Pawn))
+        {
+            pawnZobristKey ^= zobristKeys.pieces[color][type][square];
+        }
+    }
+
+    void movePiece(int from, int to) {
+        Bitboard fromTo = squareBB(from) | squareBB(to);
+        int color = (byColor[0] & squareBB(from)) ? 0 : 1;
+        int type = static_cast<int>(board[from]);
+
+        byColor[color] ^= fromTo;
+        byType[type] ^= fromTo;
+        occupied ^= fromTo;
+        board[to] = board[from];
+        board[from] = PieceType::None;
+        zobristKey ^= zobristKeys.pieces[color][type][from] ^ zobristKeys.pieces[color][type][to];
+        psqScore += psqt.scores[color][type][to];
+        psqScore -= psqt.scores[color][type][from];
+
+        if (type == static_cast<int>(PieceType::Pawn))
+        {
+            pawnZobristKey ^= zobristKeys.pieces[color][type][from] ^ zobristKeys.pieces[color][type][to];
+        }
+    }
+
+    // Plays a move generated for this position, updating the hash key incrementally
+    void makeMove(Move move);
+
+    // Takes back the last move played with makeMove
+    void unmakeMove();
+
+    // Number of moves that can be taken back
+    int movesPlayed() const {
+        return static_cast<int>(history.size());
+    }
+
+    Move lastMove() const {
+        return history.empty() ? Move::none() : history.back().move;
+    }
+
+    // The index-th move played since the position was set up
+    Move playedMove(int index) const {
+        return history[index].move;
+    }
+
+    // What the index-th move changed, and the hash key before it
+    const StateInfo& playedState(int index) const {
+        return history[index];
+    }
+
+    uint64_t key() const {
+        return zobristKey;
+    }
+
+    // Hash of the pawns alone, which the pawn structure evaluation is cached by
+    uint64_t pawnKey() const {
+        return pawnZobristKey;
+    }
+
+    // Hash of the current position computed from scratch
+    uint64_t computeKey() const;
+
+    // Material and piece-square score, positive if white is better
+    TaperedScore psq() const {
+        return psqScore;
+    }
+
+    // From MaxPhase in the opening down to 0 when only kings and pawns are left
+    int phase() const {
+        return std::min(phaseValue, MaxPhase);
+    }
+
+    Bitboard pieces() const {
+        return occupied;
+    }
+
+    Bitboard pieces(ComandColor color) const {
+        return byColor[static_cast<int>(color)];
+    }
+
+    Bitboard pieces(PieceType type) const {
+        return byType[static_cast<int>(type)];
+    }
+
+    Bitboard pieces(ComandColor color, PieceType type) const {
+        return byColor[static_cast<int>(color)] & byType[static_cast<int>(type)];
+    }
+
+    PieceType pieceOn(int square) const {
+        return board[square];
+    }
+
+    ComandColor colorOn(int square) const {
+        return (byColor[0] & squareBB(square)) ? ComandColor::White : ComandColor::Black;
+    }
+
+    bool isEmpty(int square) const {
+        return !(occupied & squareBB(square));
+    }
+
+    int kingSquare(ComandColor color) const {
+        return lsb(pieces(color, PieceType::King));
+    }
+
+    ComandColor sideToMove() const {
+        return turn;
+    }
+
+    int castling() const {
+        return castlingRights;
+    }
+
+    void setCastlingRights(int rights) {
+        zobristKey ^= zobristKeys.castling[castlingRights] ^ zobristKeys.castling[rights];
+        castlingRights = rights;
+    }
+
+    int enPassantSquare() const {
+        return epSquare;
+    }
+
+    int halfmoves() const {
+        return halfmoveClock;
+    }
+
+    int fullmoves() const {
+        return fullmoveNumber;
+    }
+
+    // Fifty-move rule, or the position already occurred since the last capture or pawn move
+    bool isDraw() const;
+
+    // Pieces of both colors attacking the square, given the occupancy
+    Bitboard attackersTo(int square, Bitboard occupancy) const;
+
+    bool isAttacked(int square, ComandColor by) const {
+        return attackersTo(square, occupied) & pieces(by);
+    }
+
+    bool inCheck() const {
+        return isAttacked(kingSquare(turn), opponent(turn));
+    }
+};
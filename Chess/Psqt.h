@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Bitboard.h"
+
+// A middlegame and an endgame score, blended by how much material is left
+struct TaperedScore {
+    int mg = 0;
+    int eg = 0;
+
+    constexpr TaperedScore& operator+=(TaperedScore other) {
+        mg += other.mg;
+        eg += other.eg;
+        return *this;
+    }
+
+    constexpr TaperedScore& operator-=(TaperedScore other) {
+        mg -= other.mg;
+        eg -= other.eg;
+        return *this;
+    }
+};
+
+// Game phase from the pieces left: 24 with all minor and major pieces on the
+// board, 0 with only kings and pawns
+constexpr int PhaseWeight[6] = { 0, 1, 1, 2, 4, 0 };
+constexpr int MaxPhase = 24;
+
+// Value of every piece on every square, material included; white's scores
+// are positive and black's negative, so a position's score is their sum
+struct PsqtTable {
+    TaperedScore scores[2][6][SquareCount];
+};
+
+extern const PsqtTable psqt;
@@ -0,0 +1,486 @@
+#include "Search.h"
+
+#include "Evaluate.h"
+#include "MoveGen.h"
+#include "Tablebase.h"
+#include "TransTable.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+// Mate scores are stored relative to the node, not the root, so they stay valid at any ply
+int scoreToTT(int score, int ply) {
+    if (score >= ScoreMateInMaxPly) return score + ply;
+    if (score <= -ScoreMateInMaxPly) return score - ply;
+    return score;
+}
+
+int scoreFromTT(int score, int ply) {
+    if (score >= ScoreMateInMaxPly) return score - ply;
+    if (score <= -ScoreMateInMaxPly) return score + ply;
+    return score;
+}
+
+// Lazy SMP helpers skip some iterations so that threads spread over different depths
+constexpr int SkipSize[20] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+constexpr int SkipPhase[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+bool skipDepth(int id, int depth) {
+    if (id == 0)
+    {
+        return false;
+    }
+
+    int index = (id - 1) % 20;
+    return ((depth + SkipPhase[index]) / SkipSize[index]) % 2 != 0;
+}
+
+uint64_t countNode(std::atomic<uint64_t>& nodes) {
+    uint64_t count = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(count, std::memory_order_relaxed);
+    return count;
+}
+
+}
+
+Move Search::bestMove() const {
+    uint16_t raw = best.load(std::memory_order_relaxed);
+    return Move(raw & 0x3F, (raw >> 6) & 0x3F, raw >> 12);
+}
+
+void Search::clearPawnHash() {
+    for (auto& worker : workers)
+    {
+        worker->eval.pawns.clear();
+    }
+}
+
+int64_t Search::elapsed() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+uint64_t Search::totalNodes() const {
+    uint64_t total = 0;
+
+    for (const auto& worker : workers)
+    {
+        total += worker->nodes.load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
+
+// Only the main thread watches the clock; helpers just follow abortAll
+void Search::checkLimits(Worker& worker) {
+    if (worker.id == 0
+        && (stopRequested.load(std::memory_order_relaxed)
+            || (limits.movetime && elapsed() >= limits.movetime)
+            || (limits.nodes && totalNodes() >= limits.nodes)))
+    {
+        abortAll = true;
+    }
+
+    if (abortAll.load(std::memory_order_relaxed))
+    {
+        worker.aborted = true;
+    }
+}
+
+Move Search::run(const Position& root, const SearchLimits& searchLimits, const Listener& onIteration) {
+    limits = searchLimits;
+    startTime = std::chrono::steady_clock::now();
+    abortAll = false;
+    completedDepth = 0;
+
+    TT.newSearch();
+
+    // Any legal move is better than none if the search is stopped straight away
+    MoveList rootMoves;
+    generateMoves(root, rootMoves);
+
+    best = rootMoves.empty() ? Move::none().raw() : rootMoves[0].raw();
+
+    if (rootMoves.size() <= 1)
+    {
+        return bestMove();
+    }
+
+    // Workers are kept between searches so their pawn tables stay filled
+    if (static_cast<int>(workers.size()) != threadCount)
+    {
+        workers.clear();
+
+        for (int id = 0; id < threadCount; id++)
+        {
+            workers.push_back(std::make_unique<Worker>());
+            workers.back()->id = id;
+        }
+    }
+
+    for (auto& worker : workers)
+    {
+        worker->pos = root;
+        worker->nodes = 0;
+        worker->aborted = false;
+        worker->eval.pawns.resize(pawnHashMB);
+        worker->history.age();
+
+        for (auto& killers : worker->killers)
+        {
+            killers[0] = killers[1] = Move::none();
+        }
+    }
+
+    std::vector<std::thread> helpers;
+
+    for (int id = 1; id < threadCount; id++)
+    {
+        helpers.emplace_back([this, id, &onIteration]() {
+            iterate(*workers[id], onIteration);
+        });
+    }
+
+    iterate(*workers[0], onIteration);
+
+    // The main thread is done, the helpers' work is of no further use
+    abortAll = true;
+
+    for (auto& helper : helpers)
+    {
+        helper.join();
+    }
+
+    return bestMove();
+}
+
+void Search::iterate(Worker& worker, const Listener& onIteration) {
+    for (int depth = 1; depth <= std::min(limits.depth, MaxPly - 1); depth++)
+    {
+        if (skipDepth(worker.id, depth))
+        {
+            continue;
+        }
+
+        int score = search(worker, -ScoreInfinite, ScoreInfinite, depth, 0);
+
+        if (worker.aborted)
+        {
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(resultMutex);
+
+            // Whichever thread finishes a new depth first provides the result
+            if (depth > completedDepth)
+            {
+                completedDepth = depth;
+                best = worker.pvTable[0][0].raw();
+
+                if (onIteration)
+                {
+                    SearchReport report;
+
+                    report.depth = depth;
+                    report.score = score;
+                    report.time = elapsed();
+                    report.pv.assign(worker.pvTable[0], worker.pvTable[0] + worker.pvLength[0]);
+
+                    for (const auto& other : workers)
+                    {
+                        report.threadNodes.push_back(other->nodes.load(std::memory_order_relaxed));
+                        report.nodes += report.threadNodes.back();
+                        report.pawnProbes += other->eval.pawns.probes();
+                        report.pawnHits += other->eval.pawns.hits();
+                    }
+
+                    onIteration(report);
+                }
+            }
+        }
+
+        // A forced mate has been found, deeper iterations cannot improve on it
+        if (std::abs(score) >= ScoreMateInMaxPly && ScoreMate - std::abs(score) <= depth)
+        {
+            break;
+        }
+    }
+}
+
+int Search::search(Worker& worker, int alpha, int beta, int depth, int ply) {
+    bool inCheck = worker.pos.inCheck();
+
+    // Never stand pat in check: look one ply further instead
+    if (inCheck)
+    {
+        depth++;
+    }
+
+    if (depth <= 0)
+    {
+        return quiesce(worker, alpha, beta, ply);
+    }
+
+    worker.pvLength[ply] = ply;
+
+    if ((countNode(worker.nodes) & 2047) == 0)
+    {
+        checkLimits(worker);
+    }
+
+    if (worker.aborted)
+    {
+        return 0;
+    }
+
+    bool pvNode = beta - alpha > 1;
+
+    if (ply > 0)
+    {
+        if (worker.pos.isDraw())
+        {
+            return 0;
+        }
+
+        if (ply >= MaxPly - 1)
+        {
+            return evaluate(worker.pos, worker.eval);
+        }
+
+        // A shorter mate has already been found elsewhere
+        alpha = std::max(alpha, -ScoreMate + ply);
+        beta = std::min(beta, ScoreMate - ply - 1);
+
+        if (alpha >= beta)
+        {
+            return alpha;
+        }
+
+        // Endings in the tablebases are known exactly, with the distance to mate. The tables
+        // know nothing of castling or en passant, so positions that still allow them are searched
+        TablebaseResult tb;
+
+        if (popCount(worker.pos.pieces()) <= tablebases.maxPieces()
+            && worker.pos.castling() == NoCastling && worker.pos.enPassantSquare() == SquareNone
+            && tablebases.probe(worker.pos, tb))
+        {
+            return tb.wdl == TablebaseResult::Win ? ScoreMate - ply - tb.plies
+                : tb.wdl == TablebaseResult::Loss ? -ScoreMate + ply + tb.plies : 0;
+        }
+    }
+
+    TTData tt;
+    Move ttMove = Move::none();
+
+    if (TT.probe(worker.pos.key(), tt))
+    {
+        ttMove = tt.move;
+
+        if (!pvNode && tt.depth >= depth)
+        {
+            int ttScore = scoreFromTT(tt.score, ply);
+
+            if (tt.bound == Bound::Exact
+                || (tt.bound == Bound::Lower && ttScore >= beta)
+                || (tt.bound == Bound::Upper && ttScore <= alpha))
+            {
+                return ttScore;
+            }
+        }
+    }
+
+    ComandColor us = worker.pos.sideToMove();
+    Move previous = worker.pos.lastMove();
+    Move* counterMove = (previous == Move::none()) ? nullptr
+        : &worker.history.counterMoves[static_cast<int>(opponent(us))][static_cast<int>(worker.pos.pieceOn(previous.to()))][previous.to()];
+
+    MovePicker picker(worker.pos, ttMove, worker.killers[ply], counterMove ? *counterMove : Move::none(),
+        worker.history, worker.id * 2654435761u);
+
+    int originalAlpha = alpha;
+    int bestScore = -ScoreInfinite;
+    Move bestMove = Move::none();
+    int moveCount = 0;
+
+    // Quiet moves searched without a cutoff, to be penalized if a later one causes it
+    Move quietsTried[64];
+    int quietCount = 0;
+
+    for (Move move = picker.next(); move != Move::none(); move = picker.next())
+    {
+        bool quiet = !isNoisy(move);
+        int score;
+
+        moveCount++;
+        worker.pos.makeMove(move);
+
+        // The first move gets the full window, the rest are expected to fail low
+        if (moveCount == 1)
+        {
+            score = -search(worker, -beta, -alpha, depth - 1, ply + 1);
+        }
+        else
+        {
+            score = -search(worker, -alpha - 1, -alpha, depth - 1, ply + 1);
+
+            if (score > alpha && score < beta)
+            {
+                score = -search(worker, -beta, -alpha, depth - 1, ply + 1);
+            }
+        }
+
+        worker.pos.unmakeMove();
+
+        if (worker.aborted)
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+
+            if (score > alpha)
+            {
+                alpha = score;
+                bestMove = move;
+
+                worker.pvTable[ply][ply] = move;
+
+                for (int next = ply + 1; next < worker.pvLength[ply + 1]; next++)
+                {
+                    worker.pvTable[ply][next] = worker.pvTable[ply + 1][next];
+                }
+
+                worker.pvLength[ply] = std::max(worker.pvLength[ply + 1], ply + 1);
+
+                if (alpha >= beta)
+                {
+                    if (quiet)
+                    {
+                        updateQuietStats(worker, move, quietsTried, quietCount, counterMove, depth, ply);
+                    }
+
+                    break;
+                }
+            }
+        }
+
+        if (quiet && quietCount < 64)
+        {
+            quietsTried[quietCount++] = move;
+        }
+    }
+
+    if (moveCount == 0)
+    {
+        return inCheck ? -ScoreMate + ply : 0;
+    }
+
+    Bound bound = (bestScore >= beta) ? Bound::Lower : (bestScore > originalAlpha) ? Bound::Exact : Bound::Upper;
+
+    TT.store(worker.pos.key(), bestMove, scoreToTT(bestScore, ply), 0, depth, bound);
+
+    return bestScore;
+}
+
+// A quiet move that caused a cutoff becomes a killer at this ply and the counter
+// move of the move before; it gains history, the quiet moves tried before it lose some
+void Search::updateQuietStats(Worker& worker, Move move, const Move* quietsTried, int quietCount, Move* counterMove, int depth, int ply) {
+    Move* killers = worker.killers[ply];
+
+    if (killers[0] != move)
+    {
+        killers[1] = killers[0];
+        killers[0] = move;
+    }
+
+    if (counterMove)
+    {
+        *counterMove = move;
+    }
+
+    ComandColor us = worker.pos.sideToMove();
+    int bonus = std::min(32 * depth * depth, MoveHistory::MaxScore / 4);
+
+    worker.history.update(us, move, bonus);
+
+    for (int i = 0; i < quietCount; i++)
+    {
+        worker.history.update(us, quietsTried[i], -bonus);
+    }
+}
+
+int Search::quiesce(Worker& worker, int alpha, int beta, int ply) {
+    worker.pvLength[ply] = ply;
+
+    if ((countNode(worker.nodes) & 2047) == 0)
+    {
+        checkLimits(worker);
+    }
+
+    if (worker.aborted)
+    {
+        return 0;
+    }
+
+    if (ply >= MaxPly - 1)
+    {
+        return evaluate(worker.pos, worker.eval);
+    }
+
+    bool inCheck = worker.pos.inCheck();
+
+    MovePicker picker(worker.pos, worker.history, inCheck);
+
+    if (picker.noLegalMoves())
+    {
+        return inCheck ? -ScoreMate + ply : 0;
+    }
+
+    int bestScore = -ScoreInfinite;
+
+    // Out of check the side to move may decline every capture
+    if (!inCheck)
+    {
+        bestScore = evaluate(worker.pos, worker.eval);
+
+        if (bestScore >= beta)
+        {
+            return bestScore;
+        }
+
+        alpha = std::max(alpha, bestScore);
+    }
+
+    for (Move move = picker.next(); move != Move::none(); move = picker.next())
+    {
+        worker.pos.makeMove(move);
+        int score = -quiesce(worker, -beta, -alpha, ply + 1);
+        worker.pos.unmakeMove();
+
+        if (worker.aborted)
+        {
+            return 0;
+        }
+
+        if (score > bestScore)
+        {
+            bestScore = score;
+
+            if (score > alpha)
+            {
+                alpha = score;
+
+                if (alpha >= beta)
+                {
+                    break;
+                }
+            }
+        }
+    }
+
+    return bestScore;
+}
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "Evaluate.h"
+#include "MovePicker.h"
+#include "Position.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+constexpr int MaxPly = 128;
+
+constexpr int ScoreInfinite = 32001;
+constexpr int ScoreMate = 32000;
+constexpr int ScoreMateInMaxPly = ScoreMate - MaxPly;
+
+// When to stop thinking; a zero time or node limit means no limit
+struct SearchLimits {
+    int depth = MaxPly - 1;
+    int64_t movetime = 0;
+    uint64_t nodes = 0;
+};
+
+// What the search found in one completed iteration
+struct SearchReport {
+    int depth = 0;
+    int score = 0;
+    uint64_t nodes = 0;
+    int64_t time = 0;
+    std::vector<Move> pv;
+
+    // Nodes searched by each thread, the main thread first
+    std::vector<uint64_t> threadNodes;
+
+    // Pawn table lookups of all threads since their tables were cleared
+    uint64_t pawnProbes = 0;
+    uint64_t pawnHits = 0;
+
+    uint64_t nps() const {
+        return time > 0 ? nodes * 1000 / time : 0;
+    }
+
+    // Share of pawn table lookups that found their pawns, in percent
+    double pawnHitRate() const {
+        return pawnProbes ? 100.0 * pawnHits / pawnProbes : 0.0;
+    }
+};
+
+// Iterative-deepening principal variation search over a copy of the position.
+// With more than one thread it runs Lazy SMP: every thread searches the same
+// root with the transposition table shared, helpers skip some depths and
+// order quiet moves differently so they fill the table with other lines.
+// run() blocks the calling thread, which becomes the main search thread;
+// stop() and bestMove() may be called from any other thread while it runs.
+class Search {
+public:
+    using Listener = std::function<void(const SearchReport&)>;
+
+    Move run(const Position& root, const SearchLimits& searchLimits, const Listener& onIteration = {});
+
+    // Number of threads used by the next run(), at least one
+    void setThreads(int count) {
+        threadCount = std::max(count, 1);
+    }
+
+    int threads() const {
+        return threadCount;
+    }
+
+    // Size of each thread's pawn structure cache, from the next run() on
+    void setPawnHash(int sizeMB) {
+        pawnHashMB = std::max(sizeMB, 1);
+    }
+
+    int pawnHash() const {
+        return pawnHashMB;
+    }
+
+    // Empties the pawn tables, which are otherwise kept from one search to the next
+    void clearPawnHash();
+
+    // Makes a running search return as soon as possible
+    void stop() {
+        stopRequested = true;
+    }
+
+    // Must be called before reusing a search that has been stopped
+    void resetStop() {
+        stopRequested = false;
+    }
+
+    // Best root move of the deepest completed iteration
+    Move bestMove() const;
+
+private:
+    // Everything one search thread writes to while searching
+    struct Worker {
+        int id = 0;
+        Position pos;
+        EvalState eval;
+        std::atomic<uint64_t> nodes{ 0 };
+        bool aborted = false;
+
+        Move pvTable[MaxPly][MaxPly];
+        int pvLength[MaxPly];
+
+        // Quiet moves that caused a cutoff at each ply, newest first
+        Move killers[MaxPly][2];
+        MoveHistory history;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    int threadCount = 1;
+    int pawnHashMB = DefaultPawnHashMB;
+
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point startTime;
+
+    std::atomic<bool> stopRequested{ false };
+    std::atomic<bool> abortAll{ false };
+    std::atomic<uint16_t> best{ 0 };
+
+    // Guards the reported result, which any thread may improve
+    std::mutex resultMutex;
+    int completedDepth = 0;
+
+    void iterate(Worker& worker, const Listener& onIteration);
+    int search(Worker& worker, int alpha, int beta, int depth, int ply);
+    int quiesce(Worker& worker, int alpha, int beta, int ply);
+    void updateQuietStats(Worker& worker, Move move, const Move* quietsTried, int quietCount, Move* counterMove, int depth, int ply);
+    void checkLimits(Worker& worker);
+    uint64_t totalNodes() const;
+    int64_t elapsed() const;
+};
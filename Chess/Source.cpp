@@ -8,22 +8,29 @@
 #include <string>
 #include <memory>
 #include <tuple>
+#include <cstdlib>
+#include <fstream>
+#include <ctime>
+
+#include "Position.h"
+#include "MoveGen.h"
+#include "TransTable.h"
+#include "Engine.h"
+#include "Book.h"
+#include "Tablebase.h"
+#include "Nnue.h"
+#include "Pgn.h"
+#include "Uci.h"
+#include "TextureCache.h"
 
 using std::cout, std::endl, std::vector;
 using namespace sf;
 
-RenderWindow window(VideoMode(600, 600), "Chess game");
+// Opened in main, which may also run without a window as a UCI engine
+RenderWindow window;
 
 class Board;
 
-enum class ComandColor {
-    White, Black
-};
-
-enum class FigureStyle {
-    Default, Style1, Style2
-};
-
 FigureStyle currentStyle = FigureStyle::Default;
 
 class Figure {
@@ -31,114 +38,43 @@ public:
     virtual ~Figure() = default;
     virtual void draw(RenderWindow& window) const = 0;
     virtual bool isType(const std::string& type) const = 0;
-    virtual void handleMouse(float mouse_x, float mouse_y) = 0;
+    virtual PieceType pieceType() const = 0;
 
-    virtual vector<Vector2f> validMoves(const Board& board) const = 0;
+    // Tints the piece while the mouse is over it
+    void hoverEffect() {
+        sprite.setColor(Color(255, 255, 170));
+    }
 
-    virtual void hoverEffect(float, float) {}
-    virtual void resetColor() {}
+    void resetColor() {
+        sprite.setColor(Color::White);
+    }
 
-    Texture texture{};
     Sprite sprite{};
     ComandColor comandColor{};
-    Mouse::Button raising{};
     Vector2f position{};
-};
-
-// figures classes
-class Pawn : public Figure {
-private:
-    bool isRaised = false;
-    Vector2f offset;
-
-    const float cellSize = 75.f;
-
-public:
-    Pawn(float x, float y, ComandColor colorCom) {
-        std::string stylePath;
-
-        switch (currentStyle)
-        {
-        case FigureStyle::Style1: stylePath = "Skins/memeSkins/";
-            break;
-        case FigureStyle::Style2: stylePath = "Skins/memeSkins2/";
-            break;
-        default: stylePath = "Skins/Default/";
-            break;
-        }
-
-        if (colorCom == ComandColor::White)
-        {
-            if (!texture.loadFromFile(stylePath + "W_Pawn.png"))
-            {
-                std::cerr << "Load white king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/W_Pawn.png"))
-                {
-                    std::cerr << "Load default white king texture - failed!" << endl;
-                }
-            }
-        }
-        else
-        {
-            if (!texture.loadFromFile(stylePath + "B_Pawn.png"))
-            {
-                std::cerr << "Load black king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/B_Pawn.png"))
-                {
-                    std::cerr << "Load default black king texture - failed!" << endl;
-                }
-            }
-        }
-
-        sprite.setTexture(texture);
 
-        float scale = 60.f / std::max(texture.getSize().x, texture.getSize().y);
-        sprite.setScale(scale, scale);
+protected:
+    // Shows the piece in the current skin at the given cell
+    void setup(float x, float y, ComandColor color, PieceType type) {
+        IntRect rect = textureCache.rect(currentStyle, color, type);
 
-        sprite.setOrigin(texture.getSize().x / 2.f, texture.getSize().y / 2.f);
-        sprite.setPosition(x + cellSize / 2, y + cellSize / 2);
+        sprite.setTexture(textureCache.atlas(currentStyle));
+        sprite.setTextureRect(rect);
+        sprite.setOrigin(rect.width / 2.f, rect.height / 2.f);
+        sprite.setPosition(x + 75.f / 2, y + 75.f / 2);
 
-        comandColor = colorCom;
-        raising = Mouse::Left;
+        comandColor = color;
         position = Vector2f(x, y);
     }
+};
 
-    void handleMouse(float mouse_x, float mouse_y) override {
-        FloatRect bounds = sprite.getGlobalBounds();
-
-        if (!isRaised)
-        {
-            if (bounds.contains(mouse_x, mouse_y) && Mouse::isButtonPressed(raising))
-            {
-                isRaised = true;
-
-                offset.x = sprite.getPosition().x - mouse_x;
-                offset.y = sprite.getPosition().y - mouse_y;
-            }
-        }
-        else
-        {
-            sprite.setPosition(mouse_x + offset.x, mouse_y + offset.y);
-
-            if (!Mouse::isButtonPressed(raising))
-            {
-                isRaised = false;
-
-                float newX = std::round((sprite.getPosition().x) / cellSize) * cellSize;
-                float newY = std::round((sprite.getPosition().y) / cellSize) * cellSize;
-
-                sprite.setPosition(newX, newY);
-            }
-        }
+// figures classes
+class Pawn : public Figure {
+public:
+    Pawn(float x, float y, ComandColor colorCom) {
+        setup(x, y, colorCom, PieceType::Pawn);
     }
 
-    vector<Vector2f> validMoves(const Board& board) const override;
-
-    void hoverEffect(float mouse_x, float mouse_y) override {}
-    void resetColor() override {}
-
     void draw(RenderWindow& window) const override {
         window.draw(sprite);
     }
@@ -146,101 +82,18 @@ public:
     bool isType(const std::string& type) const override {
         return type == "Pawn";
     }
+
+    PieceType pieceType() const override {
+        return PieceType::Pawn;
+    }
 };
 
 class Rook : public Figure {
-private:
-    bool isRaised = false;
-    Vector2f offset;
-
-    const float cellSize = 75.f;
-
 public:
     Rook(float x, float y, ComandColor colorCom) {
-        std::string stylePath;
-
-        switch (currentStyle)
-        {
-        case FigureStyle::Style1: stylePath = "Skins/memeSkins/";
-            break;
-        case FigureStyle::Style2: stylePath = "Skins/memeSkins2/";
-            break;
-        default: stylePath = "Skins/Default/";
-            break;
-        }
-
-        if (colorCom == ComandColor::White)
-        {
-            if (!texture.loadFromFile(stylePath + "W_Rook.png"))
-            {
-                std::cerr << "Load white king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/W_Rook.png"))
-                {
-                    std::cerr << "Load default white king texture - failed!" << endl;
-                }
-            }
-        }
-        else
-        {
-            if (!texture.loadFromFile(stylePath + "B_Rook.png"))
-            {
-                std::cerr << "Load black king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/B_Rook.png"))
-                {
-                    std::cerr << "Load default black king texture - failed!" << endl;
-                }
-            }
-        }
-
-        sprite.setTexture(texture);
-
-        float scale = 60.f / std::max(texture.getSize().x, texture.getSize().y);
-        sprite.setScale(scale, scale);
-
-        sprite.setOrigin(texture.getSize().x / 2.f, texture.getSize().y / 2.f);
-        sprite.setPosition(x + cellSize / 2, y + cellSize / 2);
-
-        comandColor = colorCom;
-        raising = Mouse::Left;
-        position = Vector2f(x, y);
-    }
-
-    void handleMouse(float mouse_x, float mouse_y) override {
-        FloatRect bounds = sprite.getGlobalBounds();
-
-        if (!isRaised)
-        {
-            if (bounds.contains(mouse_x, mouse_y) && Mouse::isButtonPressed(raising))
-            {
-                isRaised = true;
-
-                offset.x = sprite.getPosition().x - mouse_x;
-                offset.y = sprite.getPosition().y - mouse_y;
-            }
-        }
-        else
-        {
-            sprite.setPosition(mouse_x + offset.x, mouse_y + offset.y);
-
-            if (!Mouse::isButtonPressed(raising))
-            {
-                isRaised = false;
-
-                float newX = std::round((sprite.getPosition().x) / cellSize) * cellSize;
-                float newY = std::round((sprite.getPosition().y) / cellSize) * cellSize;
-
-                sprite.setPosition(newX, newY);
-            }
-        }
+        setup(x, y, colorCom, PieceType::Rook);
     }
 
-    vector<Vector2f> validMoves(const Board& board) const override;
-
-    void hoverEffect(float mouse_x, float mouse_y) override {}
-    void resetColor() override {}
-
     void draw(RenderWindow& window) const override {
         window.draw(sprite);
     }
@@ -248,1011 +101,1007 @@ public:
     bool isType(const std::string& type) const override {
         return type == "Rook";
     }
+
+    PieceType pieceType() const override {
+        return PieceType::Rook;
+    }
 };
 
 class Knight : public Figure {
-private:
-    bool isRaised = false;
-    Vector2f offset;
-
-    const float cellSize = 75.f;
-
 public:
     Knight(float x, float y, ComandColor colorCom) {
-        std::string stylePath;
-
-        switch (currentStyle)
-        {
-        case FigureStyle::Style1: stylePath = "Skins/memeSkins/";
-            break;
-        case FigureStyle::Style2: stylePath = "Skins/memeSkins2/";
-            break;
-        default: stylePath = "Skins/Default/";
-            break;
-        }
-
-        if (colorCom == ComandColor::White)
-        {
-            if (!texture.loadFromFile(stylePath + "W_Knight.png"))
-            {
-                std::cerr << "Load white king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/W_Knight.png"))
-                {
-                    std::cerr << "Load default white king texture - failed!" << endl;
-                }
-            }
-        }
-        else
-        {
-            if (!texture.loadFromFile(stylePath + "B_Knight.png"))
-            {
-                std::cerr << "Load black king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/B_Knight.png"))
-                {
-                    std::cerr << "Load default black king texture - failed!" << endl;
-                }
-            }
-        }
+        setup(x, y, colorCom, PieceType::Knight);
+    }
 
-        sprite.setTexture(texture);
+    void draw(RenderWindow& window) const override {
+        window.draw(sprite);
+    }
 
-        float scale = 60.f / std::max(texture.getSize().x, texture.getSize().y);
-        sprite.setScale(scale, scale);
+    bool isType(const std::string& type) const override {
+        return type == "Knight";
+    }
 
-        sprite.setOrigin(texture.getSize().x / 2.f, texture.getSize().y / 2.f);
-        sprite.setPosition(x + cellSize / 2, y + cellSize / 2);
+    PieceType pieceType() const override {
+        return PieceType::Knight;
+    }
+};
 
-        comandColor = colorCom;
-        raising = Mouse::Left;
-        position = Vector2f(x, y);
+class Bishop : public Figure {
+public:
+    Bishop(float x, float y, ComandColor colorCom) {
+        setup(x, y, colorCom, PieceType::Bishop);
     }
 
-    void handleMouse(float mouse_x, float mouse_y) override {
-        FloatRect bounds = sprite.getGlobalBounds();
+    void draw(RenderWindow& window) const override {
+        window.draw(sprite);
+    }
 
-        if (!isRaised)
-        {
-            if (bounds.contains(mouse_x, mouse_y) && Mouse::isButtonPressed(raising))
-            {
-                isRaised = true;
+    bool isType(const std::string& type) const override {
+        return type == "Bishop";
+    }
 
-                offset.x = sprite.getPosition().x - mouse_x;
-                offset.y = sprite.getPosition().y - mouse_y;
-            }
-        }
-        else
-        {
-            sprite.setPosition(mouse_x + offset.x, mouse_y + offset.y);
+    PieceType pieceType() const override {
+        return PieceType::Bishop;
+    }
+};
 
-            if (!Mouse::isButtonPressed(raising))
-            {
-                isRaised = false;
+class Queen : public Figure {
+public:
+    Queen(float x, float y, ComandColor colorCom) {
+        setup(x, y, colorCom, PieceType::Queen);
+    }
 
-                float newX = std::round((sprite.getPosition().x) / cellSize) * cellSize;
-                float newY = std::round((sprite.getPosition().y) / cellSize) * cellSize;
+    void draw(RenderWindow& window) const override {
+        window.draw(sprite);
+    }
 
-                sprite.setPosition(newX, newY);
-            }
-        }
+    bool isType(const std::string& type) const override {
+        return type == "Queen";
     }
 
-    vector<Vector2f> validMoves(const Board& board) const override;
+    PieceType pieceType() const override {
+        return PieceType::Queen;
+    }
+};
 
-    void hoverEffect(float mouse_x, float mouse_y) override {}
-    void resetColor() override {}
+class King : public Figure {
+public:
+    King(float x, float y, ComandColor colorCom) {
+        setup(x, y, colorCom, PieceType::King);
+    }
 
     void draw(RenderWindow& window) const override {
         window.draw(sprite);
     }
 
     bool isType(const std::string& type) const override {
-        return type == "Knight";
+        return type == "King";
     }
-};
 
-class Bishop : public Figure {
-private:
-    bool isRaised = false;
-    Vector2f offset;
+    PieceType pieceType() const override {
+        return PieceType::King;
+    }
+};
 
-    const float cellSize = 75.f;
+std::unique_ptr<Figure> makeFigure(PieceType type, float x, float y, ComandColor color) {
+    switch (type)
+    {
+    case PieceType::Pawn: return std::make_unique<Pawn>(x, y, color);
+    case PieceType::Rook: return std::make_unique<Rook>(x, y, color);
+    case PieceType::Knight: return std::make_unique<Knight>(x, y, color);
+    case PieceType::Bishop: return std::make_unique<Bishop>(x, y, color);
+    case PieceType::Queen: return std::make_unique<Queen>(x, y, color);
+    default: return std::make_unique<King>(x, y, color);
+    }
+}
 
-public:
-    Bishop(float x, float y, ComandColor colorCom) {
-        std::string stylePath;
+// Batching: everything on the board goes into one triangle list textured
+// with the skin atlas; plain shapes sample its white texel.
+void appendShape(VertexArray& batch, const Shape& shape) {
+    const Transform& transform = shape.getTransform();
+    Vector2f texel = TextureCache::whiteTexel();
+    Color color = shape.getFillColor();
+    Vector2f first = transform.transformPoint(shape.getPoint(0));
 
-        switch (currentStyle)
-        {
-        case FigureStyle::Style1: stylePath = "Skins/memeSkins/";
-            break;
-        case FigureStyle::Style2: stylePath = "Skins/memeSkins2/";
-            break;
-        default: stylePath = "Skins/Default/";
-            break;
-        }
+    for (std::size_t i = 1; i + 1 < shape.getPointCount(); i++)
+    {
+        batch.append(Vertex(first, color, texel));
+        batch.append(Vertex(transform.transformPoint(shape.getPoint(i)), color, texel));
+        batch.append(Vertex(transform.transformPoint(shape.getPoint(i + 1)), color, texel));
+    }
+}
 
-        if (colorCom == ComandColor::White)
-        {
-            if (!texture.loadFromFile(stylePath + "W_Bishop.png"))
-            {
-                std::cerr << "Load white king texture - failed!" << endl;
+void appendSprite(VertexArray& batch, const Sprite& sprite) {
+    FloatRect bounds = sprite.getGlobalBounds();
+    IntRect rect = sprite.getTextureRect();
+    Color color = sprite.getColor();
 
-                if (!texture.loadFromFile("Skins/Default/W_Bishop.png"))
-                {
-                    std::cerr << "Load default white king texture - failed!" << endl;
-                }
-            }
-        }
-        else
-        {
-            if (!texture.loadFromFile(stylePath + "B_Bishop.png"))
-            {
-                std::cerr << "Load black king texture - failed!" << endl;
+    Vector2f topLeft(bounds.left, bounds.top);
+    Vector2f topRight(bounds.left + bounds.width, bounds.top);
+    Vector2f bottomLeft(bounds.left, bounds.top + bounds.height);
+    Vector2f bottomRight(bounds.left + bounds.width, bounds.top + bounds.height);
 
-                if (!texture.loadFromFile("Skins/Default/B_Bishop.png"))
-                {
-                    std::cerr << "Load default black king texture - failed!" << endl;
-                }
-            }
-        }
+    Vector2f texTopLeft(static_cast<float>(rect.left), static_cast<float>(rect.top));
+    Vector2f texTopRight(static_cast<float>(rect.left + rect.width), static_cast<float>(rect.top));
+    Vector2f texBottomLeft(static_cast<float>(rect.left), static_cast<float>(rect.top + rect.height));
+    Vector2f texBottomRight(static_cast<float>(rect.left + rect.width), static_cast<float>(rect.top + rect.height));
 
-        sprite.setTexture(texture);
+    batch.append(Vertex(topLeft, color, texTopLeft));
+    batch.append(Vertex(topRight, color, texTopRight));
+    batch.append(Vertex(bottomRight, color, texBottomRight));
 
-        float scale = 60.f / std::max(texture.getSize().x, texture.getSize().y);
-        sprite.setScale(scale, scale);
+    batch.append(Vertex(topLeft, color, texTopLeft));
+    batch.append(Vertex(bottomRight, color, texBottomRight));
+    batch.append(Vertex(bottomLeft, color, texBottomLeft));
+}
 
-        sprite.setOrigin(texture.getSize().x / 2.f, texture.getSize().y / 2.f);
-        sprite.setPosition(x + cellSize / 2, y + cellSize / 2);
+class Board {
+private:
+    std::vector<std::unique_ptr<Figure>> figures;
+    std::vector<RectangleShape> blocks;
+    Figure* selectedFigure = nullptr;
+    Vector2f selectOffset;
+    Position pos;
+    std::string startFen = StartFen;
+    int hoveredSquare = SquareNone;
+
+    // Legal moves of the side to move, generated once per position: the
+    // destinations of each from-square and the move for each (from, to) pair,
+    // so highlighting and drop checks are lookups. Promotions keep the queen.
+    MoveList legalMoves;
+    Bitboard destinations[SquareCount]{};
+    Move routes[SquareCount][SquareCount];
+    bool movesStale = true;
+
+    void refreshMoves() {
+        if (!movesStale)
+        {
+            return;
+        }
 
-        comandColor = colorCom;
-        raising = Mouse::Left;
-        position = Vector2f(x, y);
-    }
+        legalMoves.clear();
+        generateMoves(pos, legalMoves);
 
-    void handleMouse(float mouse_x, float mouse_y) override {
-        FloatRect bounds = sprite.getGlobalBounds();
+        for (auto& bb : destinations)
+        {
+            bb = 0;
+        }
 
-        if (!isRaised)
+        // Generated queen first, so the first move of a (from, to) pair is kept
+        for (Move move : legalMoves)
         {
-            if (bounds.contains(mouse_x, mouse_y) && Mouse::isButtonPressed(raising))
+            if (!(destinations[move.from()] & squareBB(move.to())))
             {
-                isRaised = true;
-
-                offset.x = sprite.getPosition().x - mouse_x;
-                offset.y = sprite.getPosition().y - mouse_y;
+                destinations[move.from()] |= squareBB(move.to());
+                routes[move.from()][move.to()] = move;
             }
         }
-        else
-        {
-            sprite.setPosition(mouse_x + offset.x, mouse_y + offset.y);
 
-            if (!Mouse::isButtonPressed(raising))
-            {
-                isRaised = false;
+        movesStale = false;
+    }
 
-                float newX = std::round((sprite.getPosition().x) / cellSize) * cellSize;
-                float newY = std::round((sprite.getPosition().y) / cellSize) * cellSize;
+    vector<CircleShape> moveIndicators;
 
-                sprite.setPosition(newX, newY);
-            }
-        }
-    }
+    // Rebuilt every frame, kept to reuse its memory
+    mutable VertexArray batch{ Triangles };
 
-    vector<Vector2f> validMoves(const Board& board) const override;
+    // The squares and coordinates never change during a game, so they are drawn
+    // once into this texture at the window's pixel size and shown as one quad
+    mutable RenderTexture boardLayer;
+    mutable bool boardLayerDirty = true;
+    mutable Vector2u boardLayerPixels;
+    Font coordinateFont;
+    bool hasCoordinateFont = false;
 
-    void hoverEffect(float mouse_x, float mouse_y) override {}
-    void resetColor() override {}
+    // A failed attempt is not repeated until the size or the theme changes
+    void buildBoardLayer(Vector2u pixels) const {
+        boardLayerPixels = pixels;
+        boardLayerDirty = false;
 
-    void draw(RenderWindow& window) const override {
-        window.draw(sprite);
-    }
+        // A minimized window has no pixels to draw into
+        if (pixels.x == 0 || pixels.y == 0)
+        {
+            return;
+        }
 
-    bool isType(const std::string& type) const override {
-        return type == "Bishop";
-    }
-};
+        if (!boardLayer.create(pixels.x, pixels.y))
+        {
+            std::cerr << "Create board layer - failed!" << endl;
+            return;
+        }
 
-class Queen : public Figure {
-private:
-    bool isRaised = false;
-    Vector2f offset;
+        float scaleX = pixels.x / (8 * cellSize);
+        float scaleY = pixels.y / (8 * cellSize);
 
-    const float cellSize = 75.f;
+        Transform toPixels;
+        toPixels.scale(scaleX, scaleY);
 
-public:
-    Queen(float x, float y, ComandColor colorCom) {
-        std::string stylePath;
+        boardLayer.clear();
 
-        switch (currentStyle)
+        for (const auto& block : blocks)
         {
-        case FigureStyle::Style1: stylePath = "Skins/memeSkins/";
-            break;
-        case FigureStyle::Style2: stylePath = "Skins/memeSkins2/";
-            break;
-        default: stylePath = "Skins/Default/";
-            break;
+            boardLayer.draw(block, RenderStates(toPixels));
         }
 
-        if (colorCom == ComandColor::White)
+        // File letters along the last row, rank numbers down the first column,
+        // each in the color of the other square so they stay readable
+        if (hasCoordinateFont)
         {
-            if (!texture.loadFromFile(stylePath + "W_Queen.png"))
-            {
-                std::cerr << "Load white king texture - failed!" << endl;
+            unsigned characterSize = static_cast<unsigned>(14 * std::min(scaleX, scaleY));
 
-                if (!texture.loadFromFile("Skins/Default/W_Queen.png"))
-                {
-                    std::cerr << "Load default white king texture - failed!" << endl;
-                }
-            }
-        }
-        else
-        {
-            if (!texture.loadFromFile(stylePath + "B_Queen.png"))
+            for (int i = 0; i < 8; i++)
             {
-                std::cerr << "Load black king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/B_Queen.png"))
-                {
-                    std::cerr << "Load default black king texture - failed!" << endl;
-                }
+                Text file(std::string(1, static_cast<char>('a' + i)), coordinateFont, characterSize);
+                file.setFillColor((i + 7) % 2 ? Color(72, 60, 50) : Color::White);
+                file.setPosition(((i + 1) * cellSize - 12) * scaleX, (8 * cellSize - 20) * scaleY);
+                boardLayer.draw(file);
+
+                Text rank(std::string(1, static_cast<char>('1' + i)), coordinateFont, characterSize);
+                rank.setFillColor(i % 2 ? Color(72, 60, 50) : Color::White);
+                rank.setPosition(3 * scaleX, (i * cellSize + 2) * scaleY);
+                boardLayer.draw(rank);
             }
         }
 
-        sprite.setTexture(texture);
+        boardLayer.display();
+    }
 
-        float scale = 60.f / std::max(texture.getSize().x, texture.getSize().y);
-        sprite.setScale(scale, scale);
+    const float cellSize = 75.f;
 
-        sprite.setOrigin(texture.getSize().x / 2.f, texture.getSize().y / 2.f);
-        sprite.setPosition(x + cellSize / 2, y + cellSize / 2);
+    // Figure standing on each square, so hit tests and moves need no search
+    Figure* squareFigures[SquareCount]{};
 
-        comandColor = colorCom;
-        raising = Mouse::Left;
-        position = Vector2f(x, y);
+    Figure* figureAt(int square) const {
+        return squareFigures[square];
     }
 
-    void handleMouse(float mouse_x, float mouse_y) override {
-        FloatRect bounds = sprite.getGlobalBounds();
+    void removeFigure(Figure* target) {
+        int square = squareAt(target->position);
 
-        if (!isRaised)
+        if (squareFigures[square] == target)
         {
-            if (bounds.contains(mouse_x, mouse_y) && Mouse::isButtonPressed(raising))
-            {
-                isRaised = true;
-
-                offset.x = sprite.getPosition().x - mouse_x;
-                offset.y = sprite.getPosition().y - mouse_y;
-            }
+            squareFigures[square] = nullptr;
         }
-        else
-        {
-            sprite.setPosition(mouse_x + offset.x, mouse_y + offset.y);
-
-            if (!Mouse::isButtonPressed(raising))
-            {
-                isRaised = false;
-
-                float newX = std::round((sprite.getPosition().x) / cellSize) * cellSize;
-                float newY = std::round((sprite.getPosition().y) / cellSize) * cellSize;
 
-                sprite.setPosition(newX, newY);
-            }
-        }
+        figures.erase(std::remove_if(figures.begin(), figures.end(),
+            [target](const auto& f) { return f.get() == target; }), figures.end());
     }
 
-    vector<Vector2f> validMoves(const Board& board) const override;
-
-    void hoverEffect(float mouse_x, float mouse_y) override {}
-    void resetColor() override {}
+    void placeFigure(Figure* figure, int square) {
+        int from = squareAt(figure->position);
 
-    void draw(RenderWindow& window) const override {
-        window.draw(sprite);
-    }
+        if (squareFigures[from] == figure)
+        {
+            squareFigures[from] = nullptr;
+        }
 
-    bool isType(const std::string& type) const override {
-        return type == "Queen";
+        squareFigures[square] = figure;
+        figure->position = cellPosition(square);
+        figure->sprite.setPosition(figure->position.x + cellSize / 2, figure->position.y + cellSize / 2);
     }
-};
 
-class King : public Figure {
-private:
-    bool isRaised = false;
-    Vector2f offset;
+    // Mirrors the move on the figures, then plays it on the position
+    void applyMove(Move move) {
+        int from = move.from();
+        int to = move.to();
+        Figure* moving = figureAt(from);
 
-    const float cellSize = 75.f;
+        if (move.isCapture())
+        {
+            int captured = (move.flags() == Move::EnPassant) ? makeSquare(fileOf(to), rankOf(from)) : to;
+            removeFigure(figureAt(captured));
+        }
 
-public:
-    King(float x, float y, ComandColor colorCom) {
-        std::string stylePath;
+        placeFigure(moving, to);
 
-        switch (currentStyle) 
+        if (move.flags() == Move::KingCastle)
         {
-        case FigureStyle::Style1: stylePath = "Skins/memeSkins/";
-            break;
-        case FigureStyle::Style2: stylePath = "Skins/memeSkins2/";
-            break;
-        default: stylePath = "Skins/Default/";
-            break;
+            placeFigure(figureAt(to + 1), to - 1);
         }
-
-        if (colorCom == ComandColor::White) 
+        else if (move.flags() == Move::QueenCastle)
         {
-            if (!texture.loadFromFile(stylePath + "W_King.png"))
-            {
-                std::cerr << "Load white king texture - failed!" << endl;
-
-                if (!texture.loadFromFile("Skins/Default/W_King.png")) 
-                {
-                    std::cerr << "Load default white king texture - failed!" << endl;
-                }
-            }
+            placeFigure(figureAt(to - 2), to + 1);
         }
-        else 
+        else if (move.isPromotion())
         {
-            if (!texture.loadFromFile(stylePath + "B_King.png")) 
-            {
-                std::cerr << "Load black king texture - failed!" << endl;
+            ComandColor color = moving->comandColor;
+            Vector2f cell = cellPosition(to);
 
-                if (!texture.loadFromFile("Skins/Default/B_King.png")) 
-                {
-                    std::cerr << "Load default black king texture - failed!" << endl;
-                }
-            }
+            removeFigure(moving);
+            figures.push_back(makeFigure(move.promotionType(), cell.x, cell.y, color));
+            squareFigures[to] = figures.back().get();
         }
 
-        sprite.setTexture(texture);
-
-        float scale = 60.f / std::max(texture.getSize().x, texture.getSize().y);
-        sprite.setScale(scale, scale);
-
-        sprite.setOrigin(texture.getSize().x / 2.f, texture.getSize().y / 2.f);
-        sprite.setPosition(x + cellSize / 2, y + cellSize / 2);
-
-        comandColor = colorCom;
-        raising = Mouse::Left;
-        position = Vector2f(x, y);
+        pos.makeMove(move);
+        movesStale = true;
     }
 
-    void handleMouse(float mouse_x, float mouse_y) override {
-        FloatRect bounds = sprite.getGlobalBounds();
+public:
+    Board() {
+        hasCoordinateFont = coordinateFont.loadFromFile("ofont.ru_Arial.ttf");
 
-        if (!isRaised)
+        if (!hasCoordinateFont)
         {
-            if (bounds.contains(mouse_x, mouse_y) && Mouse::isButtonPressed(raising))
-            {
-                isRaised = true;
-
-                offset.x = sprite.getPosition().x - mouse_x;
-                offset.y = sprite.getPosition().y - mouse_y;
-            }
-        }
-        else
-        {
-            sprite.setPosition(mouse_x + offset.x, mouse_y + offset.y);
-
-            if (!Mouse::isButtonPressed(raising))
-            {
-                isRaised = false;
-
-                float newX = std::round((sprite.getPosition().x) / cellSize) * cellSize;
-                float newY = std::round((sprite.getPosition().y) / cellSize) * cellSize;
-
-                sprite.setPosition(newX, newY);
-            }
+            std::cerr << "Load font ofont.ru_Arial.ttf - failed!" << endl;
         }
     }
 
-    vector<Vector2f> validMoves(const Board& board) const override;
-
-    void hoverEffect(float mouse_x, float mouse_y) override {}
-    void resetColor() override {}
+    void addFigure(std::unique_ptr<Figure> figure) {
+        int square = squareAt(figure->position);
 
-    void draw(RenderWindow& window) const override {
-        window.draw(sprite);
+        pos.putPiece(square, figure->comandColor, figure->pieceType());
+        movesStale = true;
+        squareFigures[square] = figure.get();
+        figures.push_back(std::move(figure));
     }
 
-    bool isType(const std::string& type) const override {
-        return type == "King";
+    void addBlock(const RectangleShape& block) {
+        blocks.push_back(block);
+        boardLayerDirty = true;
     }
-};
 
-class Board {
-private:
-    std::vector<std::unique_ptr<Figure>> figures;
-    std::vector<RectangleShape> blocks;
-    Figure* selectedFigure = nullptr;
-    Vector2f selectOffset;
-    ComandColor turn = ComandColor::White;
+    void setCastlingRights(int rights) {
+        pos.setCastlingRights(rights);
+        movesStale = true;
+    }
 
-    vector<CircleShape> moveIndicators;
+    const Position& getPosition() const {
+        return pos;
+    }
 
-    const float cellSize = 75.f;
+    int squareAt(const Vector2f& position) const {
+        return makeSquare(static_cast<int>(std::lround(position.x / cellSize)), static_cast<int>(std::lround(position.y / cellSize)));
+    }
 
-public:
-    void addFigure(std::unique_ptr<Figure> figure) {
-        figures.push_back(std::move(figure));
+    Vector2f cellPosition(int square) const {
+        return Vector2f(fileOf(square) * cellSize, rankOf(square) * cellSize);
     }
 
-    void addBlock(const RectangleShape& block) {
-        blocks.push_back(block);
+    // Square under a point in board coordinates; the point must be on the board
+    int squareAtPoint(const Vector2f& point) const {
+        return makeSquare(static_cast<int>(point.x / cellSize), static_cast<int>(point.y / cellSize));
     }
 
-    bool isKing(const Vector2f& position) const {
-        for (const auto& figure : figures)
+    // Mouse input, driven by window events with points in board coordinates.
+    // Each returns whether the board has to be redrawn.
+    bool pressMouse(const Vector2f& point) {
+        if (selectedFigure || !isOnBoard(point))
         {
-            if (std::abs(figure->position.x - position.x) < 1.f && std::abs(figure->position.y - position.y) < 1.f && figure->isType("King"))
-            {
-                return true;
-            }
+            return false;
         }
-        return false;
-    }
 
-    void handleMouse(float mouse_x, float mouse_y) {
-        if (!selectedFigure && Mouse::isButtonPressed(Mouse::Left)) 
+        Figure* figure = figureAt(squareAtPoint(point));
+
+        if (!figure || figure->comandColor != pos.sideToMove())
         {
-            for (auto& figure : figures)
-            {
-                FloatRect bounds = figure->sprite.getGlobalBounds();
-                if (bounds.contains(mouse_x, mouse_y) && figure->comandColor == turn)
-                {
-                    selectedFigure = figure.get();
+            return false;
+        }
 
-                    selectOffset.x = figure->sprite.getPosition().x - mouse_x;
-                    selectOffset.y = figure->sprite.getPosition().y - mouse_y;
+        clearHover();
 
-                    auto moves = figure->validMoves(*this);
-                    indicatorMove(moves);
-                    break;
-                }
-            }
-        }
-        else if (selectedFigure) 
-        {
-            selectedFigure->sprite.setPosition(mouse_x + selectOffset.x, mouse_y + selectOffset.y);
+        selectedFigure = figure;
+        selectOffset = figure->sprite.getPosition() - point;
 
-            if (!Mouse::isButtonPressed(Mouse::Left)) {
-                float newX = std::round((selectedFigure->sprite.getPosition().x - cellSize / 2) / cellSize) * cellSize + cellSize / 2;
-                float newY = std::round((selectedFigure->sprite.getPosition().y - cellSize / 2) / cellSize) * cellSize + cellSize / 2;
+        indicatorMove(squareAtPoint(point), 150);
 
-                Vector2f newPos(newX - cellSize / 2, newY - cellSize / 2);
+        return true;
+    }
 
-                auto validMoves = selectedFigure->validMoves(*this);
-                bool isValidMove = false;
+    bool moveMouse(const Vector2f& point) {
+        if (selectedFigure)
+        {
+            selectedFigure->sprite.setPosition(point + selectOffset);
+            return true;
+        }
 
-                for (const auto& move : validMoves)
-                {
-                    if (std::abs(move.x - newPos.x) < 0.1f && std::abs(move.y - newPos.y) < 0.1f) 
-                    {
-                        isValidMove = true;
-                        break;
-                    }
-                }
+        // Hover preview: the moves of the piece under the mouse, fainter than while dragging
+        int square = isOnBoard(point) ? squareAtPoint(point) : SquareNone;
 
-                if (isValidMove)
-                {
-                    Figure* target = nullptr;
-
-                    for (auto it = figures.begin(); it != figures.end(); ++it) 
-                    {
-                        if (it->get() != selectedFigure && std::abs((*it)->position.x - newPos.x) < 1.f &&
-                            std::abs((*it)->position.y - newPos.y) < 1.f)
-                        {
-                            target = it->get();
-                            break;
-                        }
-                    }
-
-                    selectedFigure->sprite.setPosition(newX, newY);
-                    selectedFigure->position = newPos;
-
-                    if (target) 
-                    {
-                        figures.erase(std::remove_if(figures.begin(), figures.end(), 
-                            [target](const auto& f) { return f.get() == target; }), figures.end());
-                    }
-
-                    turn = (turn == ComandColor::White) ? ComandColor::Black : ComandColor::White;
-
-                    moveIndicators.clear();
-                }
-                else 
-                {
-                    selectedFigure->sprite.setPosition(
-                        selectedFigure->position.x + cellSize / 2,
-                        selectedFigure->position.y + cellSize / 2);
-                    
-                    moveIndicators.clear();
-                }
+        if (square == hoveredSquare)
+        {
+            return false;
+        }
 
-                selectedFigure = nullptr;
-            }
+        clearHover();
+        refreshMoves();
+
+        if (square != SquareNone && destinations[square])
+        {
+            hoveredSquare = square;
+            figureAt(square)->hoverEffect();
+            indicatorMove(square, 70);
         }
+
+        return true;
     }
 
-    bool isSquareEmpty(const Vector2f& position) const {
-        for (const auto& figure : figures)
+    void clearHover() {
+        if (hoveredSquare != SquareNone && figureAt(hoveredSquare))
         {
-            if (std::abs(figure->position.x - position.x) < 1.f && std::abs(figure->position.y - position.y) < 1.f)
-            {
-                return false;
-            }
+            figureAt(hoveredSquare)->resetColor();
         }
-        return true;
+
+        hoveredSquare = SquareNone;
+        moveIndicators.clear();
     }
 
-    bool isOpponent(const Vector2f& position, ComandColor color) const {
-        for (const auto& figure : figures)
+    bool releaseMouse(const Vector2f& point) {
+        if (!selectedFigure)
         {
-            if (std::abs(figure->position.x - position.x) < 1.f && std::abs(figure->position.y - position.y) < 1.f && figure->comandColor != color)
-            {
-                return true;
-            }
+            return false;
+        }
+
+        // The piece lands on the square under its center.
+        // Promotions are listed queen first, so a drop on the last rank promotes to a queen
+        Vector2f center = point + selectOffset;
+        int from = squareAt(selectedFigure->position);
+
+        if (isOnBoard(center) && (destinations[from] & squareBB(squareAtPoint(center))))
+        {
+            applyMove(routes[from][squareAtPoint(center)]);
         }
-        return false;
+        else
+        {
+            placeFigure(selectedFigure, squareAt(selectedFigure->position));
+        }
+
+        moveIndicators.clear();
+        selectedFigure = nullptr;
+
+        return true;
     }
 
     bool isOnBoard(const Vector2f& position) const {
         return position.x >= 0 && position.x < 8 * cellSize && position.y >= 0 && position.y < 8 * cellSize;
     }
 
-    void indicatorMove(const vector<Vector2f>& moves) {
+    // Marks where the piece on the square can go: diamonds for captures, dots otherwise
+    void indicatorMove(int from, Uint8 alpha) {
+        refreshMoves();
         moveIndicators.clear();
 
-        for (const auto& move : moves)
+        Bitboard targets = destinations[from];
+
+        while (targets)
         {
-            if (!isKing(move))
+            int to = popLsb(targets);
+            Vector2f cell = cellPosition(to);
+
+            if (routes[from][to].isCapture())
             {
-                if (isOpponent(move, selectedFigure->comandColor))
-                {
-                    CircleShape indicator(15.f, 4);
+                CircleShape indicator(15.f, 4);
 
-                    indicator.setFillColor(Color(255, 100, 100, 150));
-                    indicator.setPosition(move.x + cellSize / 2 - 15, move.y + cellSize / 2 - 15);
+                indicator.setFillColor(Color(255, 100, 100, alpha));
+                indicator.setPosition(cell.x + cellSize / 2 - 15, cell.y + cellSize / 2 - 15);
 
-                    moveIndicators.push_back(indicator);
-                }
-                else
-                {
-                    CircleShape indicator(10.f);
+                moveIndicators.push_back(indicator);
+            }
+            else
+            {
+                CircleShape indicator(10.f);
 
-                    indicator.setFillColor(Color(124, 252, 0, 150));
-                    indicator.setPosition(move.x + cellSize / 2 - 10, move.y + cellSize / 2 - 10);
+                indicator.setFillColor(Color(124, 252, 0, alpha));
+                indicator.setPosition(cell.x + cellSize / 2 - 10, cell.y + cellSize / 2 - 10);
 
-                    moveIndicators.push_back(indicator);
-                }
+                moveIndicators.push_back(indicator);
             }
         }
     }
 
-    void changeStyle(FigureStyle newStyle, Board& board) {
-        currentStyle = newStyle;
-
-        std::vector<std::tuple<Vector2f, ComandColor, std::string>> figuresInfo;
+    // Rebuilds the figures from the position, e.g. after the skin has changed
+    void syncFigures() {
+        figures.clear();
+        selectedFigure = nullptr;
+        hoveredSquare = SquareNone;
+        moveIndicators.clear();
 
-        for (const auto& figure : board.figures) 
+        for (auto& figure : squareFigures)
         {
-            std::string type;
+            figure = nullptr;
+        }
+
+        Bitboard occupied = pos.pieces();
 
-            if (figure->isType("Pawn")) type = "Pawn";
-            else if (figure->isType("Rook")) type = "Rook";
-            else if (figure->isType("Knight")) type = "Knight";
-            else if (figure->isType("Bishop")) type = "Bishop";
-            else if (figure->isType("Queen")) type = "Queen";
-            else if (figure->isType("King")) type = "King";
+        while (occupied)
+        {
+            int square = popLsb(occupied);
+            Vector2f cell = cellPosition(square);
 
-            figuresInfo.emplace_back(figure->position, figure->comandColor, type);
+            figures.push_back(makeFigure(pos.pieceOn(square), cell.x, cell.y, pos.colorOn(square)));
+            squareFigures[square] = figures.back().get();
         }
+    }
 
-        board.figures.clear();
+    // Replaces the game with the position, keeping the current one if the FEN is invalid
+    bool loadFen(const std::string& fen) {
+        Position loaded;
 
-        for (const auto& info : figuresInfo) 
+        if (!loaded.setFen(fen))
         {
-            Vector2f pos = std::get<0>(info);
-            ComandColor color = std::get<1>(info);
-            std::string type = std::get<2>(info);
-
-            if (type == "Pawn") board.addFigure(std::make_unique<Pawn>(pos.x, pos.y, color));
-            else if (type == "Rook") board.addFigure(std::make_unique<Rook>(pos.x, pos.y, color));
-            else if (type == "Knight") board.addFigure(std::make_unique<Knight>(pos.x, pos.y, color));
-            else if (type == "Bishop") board.addFigure(std::make_unique<Bishop>(pos.x, pos.y, color));
-            else if (type == "Queen") board.addFigure(std::make_unique<Queen>(pos.x, pos.y, color));
-            else if (type == "King") board.addFigure(std::make_unique<King>(pos.x, pos.y, color));
+            return false;
         }
+
+        pos = loaded;
+        startFen = loaded.toFen();
+        movesStale = true;
+        syncFigures();
+
+        return true;
     }
 
-    void drawAll(RenderWindow& window) const {
-        for (const auto& block : blocks) 
+    const std::string& getStartFen() const {
+        return startFen;
+    }
+
+    // The moves played since the game was set up, oldest first
+    std::vector<Move> moveHistory() const {
+        std::vector<Move> moves;
+
+        for (int i = 0; i < pos.movesPlayed(); i++)
         {
-            window.draw(block);
+            moves.push_back(pos.playedMove(i));
         }
 
-        for (const auto& figure : figures) 
+        return moves;
+    }
+
+    // Plays a move that did not come from the mouse, e.g. the engine's reply
+    bool playMove(Move move) {
+        refreshMoves();
+
+        if (!legalMoves.contains(move))
         {
-            figure->draw(window);
+            return false;
         }
 
-        for (const auto& indicator : moveIndicators)
+        clearHover();
+
+        // A piece still held by the mouse goes back first, as the move may take or promote it
+        if (selectedFigure)
         {
-            window.draw(indicator);
+            placeFigure(selectedFigure, squareAt(selectedFigure->position));
+            selectedFigure = nullptr;
+            moveIndicators.clear();
         }
+
+        applyMove(move);
+        return true;
     }
-};
 
-// Logic moves for figures //
-vector<Vector2f> Pawn::validMoves(const Board& board) const {
-    vector<Vector2f> validMoves;
+    bool isDragging() const {
+        return selectedFigure != nullptr;
+    }
 
-    int direction = (comandColor == ComandColor::White) ? 1 : -1;
+    // Takes back the last move, restoring captured figures as well
+    void undoMove() {
+        if (pos.movesPlayed() > 0)
+        {
+            pos.unmakeMove();
+            movesStale = true;
+            syncFigures();
+        }
+    }
 
-    auto isInsideBoard = [&](const Vector2f& position) {
-        return position.x >= 0 && position.x < 8 * cellSize && position.y >= 0 && position.y < 8 * cellSize;
-    };
+    void changeStyle(FigureStyle newStyle, Board& board) {
+        currentStyle = newStyle;
+        board.syncFigures();
+        board.boardLayerDirty = true;
+    }
 
-    Vector2f moveForvard(position.x, position.y + direction * cellSize);
+    // The cached board layer, then pieces and move indicators in a single draw call
+    // with the dragged piece on top. The layer is redrawn only after a resize or a theme change.
+    void drawAll(RenderWindow& window) const {
+        if (boardLayerDirty || boardLayerPixels != window.getSize())
+        {
+            buildBoardLayer(window.getSize());
+        }
 
-    if (isInsideBoard(moveForvard) && board.isSquareEmpty(moveForvard))
-    {
-        validMoves.push_back(moveForvard);
+        // Until a layer has been created there is nothing to scale
+        if (boardLayer.getSize().x != 0 && boardLayer.getSize().y != 0)
+        {
+            Sprite layer(boardLayer.getTexture());
+            layer.setScale(8 * cellSize / boardLayer.getSize().x, 8 * cellSize / boardLayer.getSize().y);
+            window.draw(layer);
+        }
 
-        bool isWhiteStart = (comandColor == ComandColor::White && position.y == 1 * cellSize);
-        bool isBlackStart = (comandColor == ComandColor::Black && position.y == 6 * cellSize);
+        batch.clear();
 
-        if (isWhiteStart || isBlackStart)
+        for (const auto& figure : figures)
         {
-            Vector2f moveDouble(position.x, position.y + 2 * direction * cellSize);
-
-            if (isInsideBoard(moveDouble) && board.isSquareEmpty(moveDouble))
+            if (figure.get() != selectedFigure)
             {
-                validMoves.push_back(moveDouble);
+                appendSprite(batch, figure->sprite);
             }
         }
-    }
-
-    Vector2f captureLeft(position.x - cellSize, position.y + direction * cellSize);
-    Vector2f captureRight(position.x + cellSize, position.y + direction * cellSize);
 
-    if (isInsideBoard(captureLeft) && board.isOpponent(captureLeft, comandColor)) validMoves.push_back(captureLeft);
-    if (isInsideBoard(captureRight) && board.isOpponent(captureRight, comandColor)) validMoves.push_back(captureRight);
-
-    return validMoves;
-}
+        for (const auto& indicator : moveIndicators)
+        {
+            appendShape(batch, indicator);
+        }
 
-vector<Vector2f> Rook::validMoves(const Board& board) const {
-    vector<Vector2f> validMoves;
+        if (selectedFigure)
+        {
+            appendSprite(batch, selectedFigure->sprite);
+        }
 
-    auto isInsideBoard = [&](const Vector2f& position) {
-        return position.x >= 0 && position.x < 8 * cellSize && position.y >= 0 && position.y < 8 * cellSize;
-    };
+        window.draw(batch, RenderStates(&textureCache.atlas(currentStyle)));
+    }
+};
 
-    for (int i = 1; i < 8; i++)
+int main(int argc, char* argv[])
+{
+    initBitboards();
+
+    SearchLimits limits;
+    limits.movetime = 1000;
+
+    int threads = 1;
+    int fps = 60;
+    std::string fen = StartFen;
+    bool uciMode = false;
+    std::string bookPath;
+
+    // Startup options: --hash <MB> sets the transposition table size,
+    // --movetime <ms> how long the computer thinks per move, --threads <N> how many cores it uses,
+    // --fps <N> the frame rate cap while something moves, --fen "<FEN>" the starting position,
+    // --uci runs the engine over stdin/stdout without opening a window, --book <file> a Polyglot opening book,
+    // --tb <directory> loads the endgame tablebases generated by TbGen, --nnue <file> evaluates with a network
+    for (int i = 1; i < argc; i++)
     {
-        Vector2f newPos(position.x, position.y - i * cellSize);
+        std::string arg = argv[i];
 
-        if (!isInsideBoard(newPos)) break;
-
-        if (board.isSquareEmpty(newPos))
+        if (arg == "--hash" && i + 1 < argc)
         {
-            validMoves.push_back(newPos);
+            int sizeMB = std::atoi(argv[++i]);
+
+            if (sizeMB <= 0)
+            {
+                std::cerr << "--hash expects a size in megabytes" << endl;
+                return 2;
+            }
+
+            TT.resize(sizeMB);
         }
-        else
+        else if (arg == "--movetime" && i + 1 < argc)
         {
-            if (board.isOpponent(newPos, comandColor))
+            limits.movetime = std::atoi(argv[++i]);
+
+            if (limits.movetime <= 0)
             {
-                validMoves.push_back(newPos);
+                std::cerr << "--movetime expects milliseconds" << endl;
+                return 2;
             }
-            break;
         }
-    }
-
-    for (int i = 1; i < 8; i++)
-    {
-        Vector2f newPos(position.x, position.y + i * cellSize);
-
-        if (!isInsideBoard(newPos)) break;
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threads = std::atoi(argv[++i]);
 
-        if (board.isSquareEmpty(newPos))
+            if (threads <= 0)
+            {
+                std::cerr << "--threads expects a positive number" << endl;
+                return 2;
+            }
+        }
+        else if (arg == "--fen" && i + 1 < argc)
         {
-            validMoves.push_back(newPos);
+            fen = argv[++i];
         }
-        else
+        else if (arg == "--book" && i + 1 < argc)
+        {
+            bookPath = argv[++i];
+        }
+        else if (arg == "--tb" && i + 1 < argc)
         {
-            if (board.isOpponent(newPos, comandColor))
+            std::string directory = argv[++i];
+
+            if (!tablebases.load(directory))
             {
-                validMoves.push_back(newPos);
+                std::cerr << "No tablebases in " << directory << endl;
+                return 2;
             }
-            break;
         }
-    }
-
-    for (int i = 1; i < 8; i++)
-    {
-        Vector2f newPos(position.x - i * cellSize, position.y);
-
-        if (!isInsideBoard(newPos)) break;
+        else if (arg == "--nnue" && i + 1 < argc)
+        {
+            std::string path = argv[++i];
 
-        if (board.isSquareEmpty(newPos))
+            if (!nnue.load(path))
+            {
+                std::cerr << "Cannot load network " << path << endl;
+                return 2;
+            }
+        }
+        else if (arg == "--uci")
         {
-            validMoves.push_back(newPos);
+            uciMode = true;
         }
-        else
+        else if (arg == "--fps" && i + 1 < argc)
         {
-            if (board.isOpponent(newPos, comandColor))
+            fps = std::atoi(argv[++i]);
+
+            if (fps <= 0 || fps > 1000)
             {
-                validMoves.push_back(newPos);
+                std::cerr << "--fps expects a number from 1 to 1000" << endl;
+                return 2;
             }
-            break;
         }
     }
 
-    for (int i = 1; i < 8; i++)
+    if (uciMode)
     {
-        Vector2f newPos(position.x + i * cellSize, position.y);
+        runUci(std::cin, cout);
+        return 0;
+    }
 
-        if (!isInsideBoard(newPos)) break;
+    cout << "Hash: " << TT.sizeMB() << " MB" << endl;
 
-        if (board.isSquareEmpty(newPos))
-        {
-            validMoves.push_back(newPos);
-        }
-        else
+    OpeningBook book;
+
+    if (!bookPath.empty() && !book.open(bookPath))
+    {
+        std::cerr << "Cannot open book " << bookPath << endl;
+        return 2;
+    }
+
+    window.create(VideoMode(600, 600), "Chess game");
+
+    Board board;
+
+    for (int i = 0; i < 8; ++i) 
+    {
+        for (int j = 0; j < 8; ++j) 
         {
-            if (board.isOpponent(newPos, comandColor))
-            {
-                validMoves.push_back(newPos);
-            }
-            break;
+            RectangleShape block(Vector2f(75, 75));
+
+            block.setPosition(i * 75, j * 75);
+            block.setFillColor((i + j) % 2 ? Color::White : Color(72, 60, 50));
+
+            board.addBlock(block);
         }
     }
 
-    return validMoves;
-}
+    if (!board.loadFen(fen))
+    {
+        std::cerr << "Invalid FEN: " << fen << endl;
+        return 2;
+    }
 
-vector<Vector2f> Knight::validMoves(const Board& board) const {
-    vector<Vector2f> validMoves;
-
-    const vector<Vector2f> MovesKnight {
-        { -1 * cellSize, -2 * cellSize},
-        {  1 * cellSize, -2 * cellSize},
-        { -2 * cellSize, -1 * cellSize},
-        {  2 * cellSize, -1 * cellSize},
-        { -2 * cellSize,  1 * cellSize},
-        {  2 * cellSize,  1 * cellSize},
-        { -1 * cellSize,  2 * cellSize},
-        {  1 * cellSize,  2 * cellSize},
-    };
+    cout << "The game is running..." << endl;
+    cout << "press the key to take back a move - Backspace" << endl;
+    cout << "press the key to let the computer play the side to move (on/off) - C" << endl;
+    cout << "press the key to make the computer move now - Space" << endl;
+    cout << "press the keys to copy the position as FEN / load a FEN from the clipboard - Ctrl+C / Ctrl+V" << endl;
+    cout << "press the keys to append the game to games.pgn - Ctrl+S" << endl;
+    cout << "press the key to end the game - E" << endl;
 
-    for (const auto& move : MovesKnight)
-    {
-        Vector2f newPos(position.x + move.x, position.y + move.y);
+    // The search runs on its own thread; the loop below only polls it, so drawing never waits
+    Engine engine;
+    engine.setThreads(threads);
 
-        if (board.isOnBoard(newPos))
+    bool computerEnabled = false;
+    ComandColor computerSide = ComandColor::Black;
+    uint64_t searchedKey = 0;
+
+    // Frames are drawn only when something changed. Input arrives as events, so
+    // the loop sleeps in waitEvent until there is some; during a drag or while
+    // the engine thinks it draws at most fps times per second.
+    bool dirty = true;
+    Clock frameClock;
+
+    auto handleEvent = [&](const Event& event) {
+        bool computerTurn = computerEnabled && board.getPosition().sideToMove() == computerSide;
+
+        if (event.type == Event::MouseMoved)
         {
-            if (board.isSquareEmpty(newPos) || board.isOpponent(newPos, comandColor))
+            if (!computerTurn)
             {
-                validMoves.push_back(newPos);
+                dirty |= board.moveMouse(window.mapPixelToCoords(Vector2i(event.mouseMove.x, event.mouseMove.y)));
             }
+            return;
         }
-    }
 
-    return validMoves;
-}
+        dirty = true;
 
-vector<Vector2f> Bishop::validMoves(const Board& board) const {
-    vector<Vector2f> validMoves;
+        if (event.type == Event::Closed)
+            window.close();
 
-    const vector<Vector2f> MovesBishop {
-        {  1,  1},
-        {  1, -1},
-        { -1,  1},
-        { -1, -1},
-    };
+        // Points are mapped to board coordinates, which differ from pixels once the window has been resized
+        if (event.type == Event::MouseButtonPressed && event.mouseButton.button == Mouse::Left && !computerTurn)
+        {
+            board.pressMouse(window.mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y)));
+        }
 
-    for (const auto& move : MovesBishop)
-    {
-        for (int i = 1; i < 8; i++)
+        if (event.type == Event::MouseButtonReleased && event.mouseButton.button == Mouse::Left)
         {
-            Vector2f newPos(position.x + i * move.x * cellSize, position.y + i * move.y * cellSize);
+            board.releaseMouse(window.mapPixelToCoords(Vector2i(event.mouseButton.x, event.mouseButton.y)));
+        }
 
-            if (!board.isOnBoard(newPos))
+        if (event.type == Event::KeyPressed) 
+        {
+            if (event.key.code == Keyboard::Num1) 
             {
-                break;
+                board.changeStyle(FigureStyle::Default, board);
             }
-
-            if (board.isSquareEmpty(newPos))
+            else if (event.key.code == Keyboard::Num2) 
             {
-                validMoves.push_back(newPos);
+                board.changeStyle(FigureStyle::Style1, board);
             }
-            else if (board.isOpponent(newPos, comandColor))
+            else if (event.key.code == Keyboard::Num3) 
             {
-                validMoves.push_back(newPos);
-                break;
+                board.changeStyle(FigureStyle::Style2, board);
             }
-            else
+            else if (event.key.code == Keyboard::Backspace)
             {
-                break;
-            }
-        }
-    }
-
-    return validMoves;
-}
-
-vector<Vector2f> Queen::validMoves(const Board& board) const {
-    vector<Vector2f> validMoves;
-
-    const vector<Vector2f> MovesQueen {
-        {  1,  0 },
-        { -1,  0 },
-        {  0,  1 },
-        {  0, -1 },
-        {  1,  1 },
-        {  1, -1 },
-        { -1,  1 },
-        { -1, -1 },
-    };
+                engine.stop();
+                board.undoMove();
 
-    for (const auto& move : MovesQueen)
-    {
-        for (int i = 1; i < 8; i++)
-        {
-            Vector2f newPos(position.x + i * move.x * cellSize, position.y + i * move.y * cellSize);
+                // Go back to the player's own move, not just the computer's reply
+                if (computerEnabled && board.getPosition().sideToMove() == computerSide)
+                {
+                    board.undoMove();
+                }
 
-            if (!board.isOnBoard(newPos))
+                searchedKey = 0;
+            }
+            else if (event.key.code == Keyboard::C && !event.key.control)
             {
-                break;
+                engine.stop();
+                computerEnabled = !computerEnabled;
+                computerSide = board.getPosition().sideToMove();
+                searchedKey = 0;
             }
-
-            if (board.isSquareEmpty(newPos))
+            else if (event.key.code == Keyboard::Space)
             {
-                validMoves.push_back(newPos);
+                engine.stop();
             }
-            else if (board.isOpponent(newPos, comandColor))
+            else if (event.key.code == Keyboard::V && event.key.control)
             {
-                validMoves.push_back(newPos);
-                break;
+                std::string pasted = Clipboard::getString().toAnsiString();
+
+                engine.stop();
+                searchedKey = 0;
+
+                if (!board.loadFen(pasted))
+                {
+                    std::cerr << "Invalid FEN: " << pasted << endl;
+                }
             }
-            else
+            else if (event.key.code == Keyboard::C && event.key.control)
             {
-                break;
+                Clipboard::setString(board.getPosition().toFen());
+                cout << board.getPosition().toFen() << endl;
             }
-        }
-    }
+            else if (event.key.code == Keyboard::S && event.key.control)
+            {
+                std::ofstream file("games.pgn", std::ios::app);
 
-    return validMoves;
-}
+                if (!file)
+                {
+                    std::cerr << "Cannot open games.pgn" << endl;
+                    return;
+                }
 
-vector<Vector2f> King::validMoves(const Board& board) const {
-    vector<Vector2f> validMoves;
-
-    const vector<Vector2f> MovesKing {
-        {  1,  0 },
-        { -1,  0 },
-        {  0,  1 },
-        {  0, -1 },
-        {  1,  1 },
-        {  1, -1 },
-        { -1,  1 },
-        { -1, -1 },
+                char date[16];
+                std::time_t now = std::time(nullptr);
+                std::strftime(date, sizeof(date), "%Y.%m.%d", std::localtime(&now));
+
+                std::string result = gameResult(board.getPosition());
+                auto playerName = [&](ComandColor side) {
+                    return (computerEnabled && side == computerSide) ? "Computer" : "Player";
+                };
+
+                PgnTags tags = {
+                    { "Event", "Casual game" },
+                    { "Site", "?" },
+                    { "Date", date },
+                    { "Round", "-" },
+                    { "White", playerName(ComandColor::White) },
+                    { "Black", playerName(ComandColor::Black) },
+                    { "Result", result },
+                };
+
+                writePgn(file, tags, board.getStartFen(), board.moveHistory(), result);
+                cout << "game saved to games.pgn" << endl;
+            }
+            else if (event.key.code == Keyboard::E)
+            {
+                window.close();
+            }
+        }
     };
 
-    for (const auto& move : MovesKing)
+    while (window.isOpen())
     {
-        Vector2f newPos(position.x + move.x * cellSize, position.y + move.y * cellSize);
+        frameClock.restart();
 
-        if (!board.isOnBoard(newPos))
-        {
-            continue;
-        }
+        bool computerTurn = computerEnabled && board.getPosition().sideToMove() == computerSide;
 
-        if (board.isSquareEmpty(newPos) || board.isOpponent(newPos, comandColor))
+        if (computerTurn && !engine.thinking() && searchedKey != board.getPosition().key())
         {
-            validMoves.push_back(newPos);
-        }
-    }
-
-    return validMoves;
-}
-
-int main()
-{
-    Board board;
+            searchedKey = board.getPosition().key();
 
-    for (int i = 0; i < 8; ++i) 
-    {
-        for (int j = 0; j < 8; ++j) 
-        {
-            RectangleShape block(Vector2f(75, 75));
+            // Known openings are played from the book without thinking
+            Move bookMove = book.isOpen() ? book.pick(board.getPosition()) : Move::none();
 
-            block.setPosition(i * 75, j * 75);
-            block.setFillColor((i + j) % 2 ? Color::White : Color(72, 60, 50));
+            if (bookMove != Move::none())
+            {
+                cout << "book " << bookMove.toString() << endl;
+                board.playMove(bookMove);
+                dirty = true;
+                continue;
+            }
 
-            board.addBlock(block);
+            engine.start(board.getPosition(), limits);
         }
-    }
-
-    // figures create //
 
-    // 1) white
-    for (int i = 0; i < 8; i++)
-    {
-        board.addFigure(std::make_unique<Pawn>(i * 75, 1 * 75, ComandColor::White));
-    }
+        EngineMessage message;
 
-    board.addFigure(std::make_unique<Rook>(0 * 75.f, 0 * 75.f, ComandColor::White));
-    board.addFigure(std::make_unique<Rook>(7 * 75.f, 0 * 75.f, ComandColor::White));
-
-    board.addFigure(std::make_unique<Knight>(1 * 75.f, 0 * 75.f, ComandColor::White));
-    board.addFigure(std::make_unique<Knight>(6 * 75.f, 0 * 75.f, ComandColor::White));
+        while (engine.poll(message))
+        {
+            // Results for a position that has since been taken back are dropped
+            if (message.positionKey != board.getPosition().key())
+            {
+                continue;
+            }
 
-    board.addFigure(std::make_unique<Bishop>(2 * 75.f, 0 * 75.f, ComandColor::White));
-    board.addFigure(std::make_unique<Bishop>(5 * 75.f, 0 * 75.f, ComandColor::White));
+            if (message.type == EngineMessage::Info)
+            {
+                cout << "depth " << message.report.depth << " score " << message.report.score
+                    << " nodes " << message.report.nodes << " nps " << message.report.nps()
+                    << " time " << message.report.time << " pv";
 
-    board.addFigure(std::make_unique<Queen>(3 * 75.f, 0 * 75.f, ComandColor::White));
-    board.addFigure(std::make_unique<King>(4 * 75.f, 0 * 75.f, ComandColor::White));
+                for (Move move : message.report.pv)
+                {
+                    cout << ' ' << move.toString();
+                }
 
-    // 2) black
-    for (int i = 0; i < 8; i++)
-    {
-        board.addFigure(std::make_unique<Pawn>(i * 75, 6 * 75, ComandColor::Black));
-    }
+                cout << endl;
+            }
+            else if (computerTurn)
+            {
+                board.playMove(message.move);
+            }
 
-    board.addFigure(std::make_unique<Rook>(0 * 75.f, 7 * 75.f, ComandColor::Black));
-    board.addFigure(std::make_unique<Rook>(7 * 75.f, 7 * 75.f, ComandColor::Black));
+            dirty = true;
+        }
 
-    board.addFigure(std::make_unique<Knight>(1 * 75.f, 7 * 75.f, ComandColor::Black));
-    board.addFigure(std::make_unique<Knight>(6 * 75.f, 7 * 75.f, ComandColor::Black));
+        Event event;
 
-    board.addFigure(std::make_unique<Bishop>(2 * 75.f, 7 * 75.f, ComandColor::Black));
-    board.addFigure(std::make_unique<Bishop>(5 * 75.f, 7 * 75.f, ComandColor::Black));
+        // The search thread pushes its best move before it stops counting as thinking, so an idle
+        // engine with an empty queue has nothing left in flight and the loop may sleep
+        if (!dirty && !engine.thinking() && !engine.hasMessages() && window.waitEvent(event))
+        {
+            handleEvent(event);
+        }
 
-    board.addFigure(std::make_unique<Queen>(3 * 75.f, 7 * 75.f, ComandColor::Black));
-    board.addFigure(std::make_unique<King>(4 * 75.f, 7 * 75.f, ComandColor::Black));
+        while (window.pollEvent(event))
+        {
+            handleEvent(event);
+        }
 
-    cout << "The game is running..." << endl;
-    cout << "press the key to end the game - E" << endl;
+        if (!window.isOpen())
+        {
+            break;
+        }
 
-    while (window.isOpen())
-    {
-        Event event;
+        if (dirty)
+        {
+            window.clear();
+            board.drawAll(window);
+            window.display();
 
-        Vector2f mousePos = static_cast<Vector2f>(Mouse::getPosition(window));
+            dirty = false;
+        }
 
-        while (window.pollEvent(event))
+        if (board.isDragging() || engine.thinking())
         {
-            if (event.type == Event::Closed)
-                window.close();
+            int rest = 1000 / fps - frameClock.getElapsedTime().asMilliseconds();
 
-            if (event.type == Event::KeyPressed) 
+            if (rest > 0)
             {
-                if (event.key.code == Keyboard::Num1) 
-                {
-                    board.changeStyle(FigureStyle::Default, board);
-                }
-                else if (event.key.code == Keyboard::Num2) 
-                {
-                    board.changeStyle(FigureStyle::Style1, board);
-                }
-                else if (event.key.code == Keyboard::Num3) 
-                {
-                    board.changeStyle(FigureStyle::Style2, board);
-                }
-                else if (event.key.code == Keyboard::E)
-                {
-                    window.close();
-                    return 0;
-                }
+                sleep(milliseconds(rest));
             }
         }
-
-        board.handleMouse(mousePos.x, mousePos.y);
-
-        window.clear();
-        board.drawAll(window);
-        window.display();
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,957 @@
+#include "Tablebase.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+Tablebases tablebases;
+
+namespace {
+
+constexpr char FileMagic[4] = { 'C', 'T', 'B', '1' };
+constexpr size_t HeaderSize = 16;
+
+// Stored per position: 0 for a draw (or not yet known while building), Invalid
+// for positions that cannot occur, otherwise the plies to mate plus one. The
+// side to move wins when that number of plies is odd and loses when it is even.
+constexpr uint8_t Invalid = 0xFF;
+constexpr int MaxPlies = 253;
+
+// Exit moves (captures and promotions) leaving a position only for draws
+constexpr uint8_t ExitDraw = 0xFF;
+
+constexpr const char* PieceOrder = "KQRBNP";
+constexpr int LetterValue[6] = { 0, 9, 5, 3, 3, 1 };
+
+const PieceType LetterType[6] = {
+    PieceType::King, PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight, PieceType::Pawn
+};
+
+// The a1-d1-d4 triangle the stronger king is turned into on tables without pawns
+constexpr int TriangleSquares[10] = { 0, 1, 2, 3, 9, 10, 11, 18, 19, 27 };
+
+uint8_t encodeValue(int plies) {
+    return static_cast<uint8_t>(std::min(plies, MaxPlies) + 1);
+}
+
+bool isWinValue(uint8_t value) {
+    return value != 0 && value != Invalid && (value - 1) % 2 == 1;
+}
+
+char pieceLetter(PieceType type) {
+    for (int i = 0; i < 6; i++)
+    {
+        if (LetterType[i] == type)
+        {
+            return PieceOrder[i];
+        }
+    }
+
+    return '?';
+}
+
+int letterIndex(char letter) {
+    const char* found = std::strchr(PieceOrder, letter);
+    return (found && letter) ? static_cast<int>(found - PieceOrder) : -1;
+}
+
+// One side's pieces as letters, king first, the rest by falling value
+std::string sortSide(std::string side) {
+    std::sort(side.begin(), side.end(), [](char a, char b) { return letterIndex(a) < letterIndex(b); });
+    return side;
+}
+
+// Whether side a is at least as strong as side b, in a fixed order so every material has one name
+bool strongerSide(const std::string& a, const std::string& b) {
+    int valueA = 0, valueB = 0;
+
+    for (char c : a) valueA += LetterValue[letterIndex(c)];
+    for (char c : b) valueB += LetterValue[letterIndex(c)];
+
+    if (valueA != valueB) return valueA > valueB;
+    if (a.size() != b.size()) return a.size() > b.size();
+
+    return a >= b;
+}
+
+// Bare kings or a single minor piece cannot force mate; such endings need no table
+bool isDrawnMaterial(const std::string& white, const std::string& black) {
+    std::string all = white.substr(1) + black.substr(1);
+    return all.empty() || all == "B" || all == "N";
+}
+
+struct Material {
+    std::string name;
+    std::vector<PieceType> strong;
+    std::vector<PieceType> weak;
+    bool pawns = false;
+    uint64_t size = 0; // positions per side to move
+
+    int count() const {
+        return static_cast<int>(strong.size() + weak.size());
+    }
+};
+
+// Parses names such as "KRK" or "KBNK" in either side order
+bool parseMaterial(const std::string& text, Material& material) {
+    size_t second = text.find('K', 1);
+
+    if (text.size() < 2 || text[0] != 'K' || second == std::string::npos || text.find('K', second + 1) != std::string::npos)
+    {
+        return false;
+    }
+
+    for (char c : text)
+    {
+        if (letterIndex(c) < 0)
+        {
+            return false;
+        }
+    }
+
+    std::string first = sortSide(text.substr(0, second));
+    std::string other = sortSide(text.substr(second));
+
+    if (text.size() > MaxTablebasePieces || isDrawnMaterial(first, other))
+    {
+        return false;
+    }
+
+    if (!strongerSide(first, other))
+    {
+        std::swap(first, other);
+    }
+
+    material.name = first + other;
+    material.strong.clear();
+    material.weak.clear();
+
+    for (char c : first) material.strong.push_back(LetterType[letterIndex(c)]);
+    for (char c : other) material.weak.push_back(LetterType[letterIndex(c)]);
+
+    material.pawns = material.name.find('P') != std::string::npos;
+    material.size = material.pawns ? 32 : 10;
+
+    for (int i = 1; i < material.count(); i++)
+    {
+        material.size *= 64;
+    }
+
+    return true;
+}
+
+// Piece types of the table in board order: the kings, then the rest of each side
+PieceType slotType(const Material& material, int slot, ComandColor& color) {
+    int strongExtra = static_cast<int>(material.strong.size()) - 1;
+
+    if (slot < 2)
+    {
+        color = slot == 0 ? ComandColor::White : ComandColor::Black;
+        return PieceType::King;
+    }
+
+    if (slot - 2 < strongExtra)
+    {
+        color = ComandColor::White;
+        return material.strong[slot - 1];
+    }
+
+    color = ComandColor::Black;
+    return material.weak[slot - 1 - strongExtra];
+}
+
+void transformSquares(TablebaseBoard& board, int (*transform)(int)) {
+    for (int i = 0; i < board.count; i++)
+    {
+        board.square[i] = transform(board.square[i]);
+    }
+}
+
+int flipFile(int square) { return square ^ 7; }
+int flipRank(int square) { return square ^ 56; }
+int flipDiagonal(int square) { return makeSquare(rankOf(square), fileOf(square)); }
+
+// Equal pieces are interchangeable; keeping them in square order gives one index per position
+void sortEqualPieces(TablebaseBoard& board) {
+    for (int i = 3; i < board.count; i++)
+    {
+        for (int j = i; j > 2 && board.type[j] == board.type[j - 1] && board.color[j] == board.color[j - 1]
+            && board.square[j] < board.square[j - 1]; j--)
+        {
+            std::swap(board.square[j], board.square[j - 1]);
+        }
+    }
+}
+
+uint64_t encodeSquares(const TablebaseBoard& board, bool pawns) {
+    int king = board.square[0];
+    uint64_t index = pawns ? static_cast<uint64_t>(rankOf(king) * 4 + fileOf(king))
+        : static_cast<uint64_t>(std::find(TriangleSquares, TriangleSquares + 10, king) - TriangleSquares);
+
+    for (int i = 1; i < board.count; i++)
+    {
+        index = index * 64 + board.square[i];
+    }
+
+    return index;
+}
+
+// Index of a board already in table order. Of the boards a symmetry turns it
+// into, the one with the stronger king in the allowed region is used, and if
+// that leaves a choice (king on the a1-h8 diagonal) the one with the lower index.
+uint64_t boardIndex(TablebaseBoard board, bool pawns) {
+    if (fileOf(board.square[0]) > 3)
+    {
+        transformSquares(board, flipFile);
+    }
+
+    if (!pawns)
+    {
+        if (rankOf(board.square[0]) > 3)
+        {
+            transformSquares(board, flipRank);
+        }
+
+        if (rankOf(board.square[0]) > fileOf(board.square[0]))
+        {
+            transformSquares(board, flipDiagonal);
+        }
+    }
+
+    sortEqualPieces(board);
+    uint64_t index = encodeSquares(board, pawns);
+
+    if (!pawns && rankOf(board.square[0]) == fileOf(board.square[0]))
+    {
+        transformSquares(board, flipDiagonal);
+        sortEqualPieces(board);
+        index = std::min(index, encodeSquares(board, pawns));
+    }
+
+    return index;
+}
+
+void decodeIndex(const Material& material, uint64_t index, TablebaseBoard& board) {
+    board.count = material.count();
+
+    for (int i = board.count - 1; i >= 1; i--)
+    {
+        board.square[i] = static_cast<int>(index % 64);
+        index /= 64;
+    }
+
+    board.square[0] = material.pawns ? makeSquare(static_cast<int>(index % 4), static_cast<int>(index / 4))
+        : TriangleSquares[index];
+
+    for (int i = 0; i < board.count; i++)
+    {
+        board.type[i] = slotType(material, i, board.color[i]);
+    }
+}
+
+bool isAttacked(const TablebaseBoard& board, int square, ComandColor by, Bitboard occupied) {
+    for (int i = 0; i < board.count; i++)
+    {
+        if (board.color[i] != by)
+        {
+            continue;
+        }
+
+        Bitboard attacks = (board.type[i] == PieceType::Pawn) ? pawnAttacks(by, board.square[i])
+            : attacksFrom(board.type[i], board.square[i], occupied);
+
+        if (attacks & squareBB(square))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int kingOf(const TablebaseBoard& board, ComandColor color) {
+    for (int i = 0; i < board.count; i++)
+    {
+        if (board.type[i] == PieceType::King && board.color[i] == color)
+        {
+            return board.square[i];
+        }
+    }
+
+    return SquareNone;
+}
+
+// Calls visit(board after the move, whether it left the table) for every legal
+// move of the side to move. Captures and promotions leave the table: the
+// board passed for them has the captured piece removed and the new piece type.
+template <typename Visit>
+void forEachMove(const TablebaseBoard& board, Visit visit) {
+    ComandColor us = board.turn;
+    ComandColor them = opponent(us);
+    Bitboard occupied = board.occupied();
+    Bitboard own = 0;
+
+    for (int i = 0; i < board.count; i++)
+    {
+        if (board.color[i] == us)
+        {
+            own |= squareBB(board.square[i]);
+        }
+    }
+
+    auto play = [&](int piece, int to, PieceType promotion) {
+        TablebaseBoard after = board;
+        bool exit = promotion != PieceType::None;
+
+        after.square[piece] = to;
+        after.turn = them;
+
+        if (promotion != PieceType::None)
+        {
+            after.type[piece] = promotion;
+        }
+
+        for (int j = 0; j < after.count; j++)
+        {
+            if (j != piece && after.square[j] == to)
+            {
+                // Kings are never captured; such positions are invalid anyway
+                if (after.type[j] == PieceType::King)
+                {
+                    return;
+                }
+
+                after.count--;
+
+                for (int k = j; k < after.count; k++)
+                {
+                    after.square[k] = after.square[k + 1];
+                    after.type[k] = after.type[k + 1];
+                    after.color[k] = after.color[k + 1];
+                }
+
+                exit = true;
+                break;
+            }
+        }
+
+        if (!isAttacked(after, kingOf(after, us), them, after.occupied()))
+        {
+            visit(after, exit);
+        }
+    };
+
+    for (int i = 0; i < board.count; i++)
+    {
+        if (board.color[i] != us)
+        {
+            continue;
+        }
+
+        int from = board.square[i];
+
+        if (board.type[i] != PieceType::Pawn)
+        {
+            Bitboard targets = attacksFrom(board.type[i], from, occupied) & ~own;
+
+            while (targets)
+            {
+                play(i, popLsb(targets), PieceType::None);
+            }
+
+            continue;
+        }
+
+        int forward = (us == ComandColor::White) ? 8 : -8;
+        int lastRank = (us == ComandColor::White) ? 7 : 0;
+        int startRank = (us == ComandColor::White) ? 1 : 6;
+
+        Bitboard targets = pawnAttacks(us, from) & occupied & ~own;
+
+        if (!(occupied & squareBB(from + forward)))
+        {
+            targets |= squareBB(from + forward);
+
+            if (rankOf(from) == startRank && !(occupied & squareBB(from + 2 * forward)))
+            {
+                targets |= squareBB(from + 2 * forward);
+            }
+        }
+
+        while (targets)
+        {
+            int to = popLsb(targets);
+
+            if (rankOf(to) == lastRank)
+            {
+                for (PieceType promotion : { PieceType::Queen, PieceType::Rook, PieceType::Bishop, PieceType::Knight })
+                {
+                    play(i, to, promotion);
+                }
+            }
+            else
+            {
+                play(i, to, PieceType::None);
+            }
+        }
+    }
+}
+
+// Calls visit(board before) for every position from which the side that is not
+// to move could have reached this one without a capture or promotion
+template <typename Visit>
+void forEachPredecessor(const TablebaseBoard& board, Visit visit) {
+    ComandColor mover = opponent(board.turn);
+    Bitboard occupied = board.occupied();
+
+    for (int i = 0; i < board.count; i++)
+    {
+        if (board.color[i] != mover)
+        {
+            continue;
+        }
+
+        int to = board.square[i];
+        Bitboard origins;
+
+        if (board.type[i] == PieceType::Pawn)
+        {
+            int back = (mover == ComandColor::White) ? -8 : 8;
+            int doubleRank = (mover == ComandColor::White) ? 3 : 4;
+            int homeRank = (mover == ComandColor::White) ? 0 : 7;
+
+            origins = 0;
+
+            if (rankOf(to + back) != homeRank && !(occupied & squareBB(to + back)))
+            {
+                origins |= squareBB(to + back);
+
+                if (rankOf(to) == doubleRank && !(occupied & squareBB(to + 2 * back)))
+                {
+                    origins |= squareBB(to + 2 * back);
+                }
+            }
+        }
+        else
+        {
+            // Piece moves are symmetric: the squares it could have come from are those it attacks
+            origins = attacksFrom(board.type[i], to, occupied) & ~occupied;
+        }
+
+        while (origins)
+        {
+            TablebaseBoard before = board;
+
+            before.square[i] = popLsb(origins);
+            before.turn = mover;
+
+            visit(before);
+        }
+    }
+}
+
+// Brings a board with the pieces of a material set into the table's order and
+// orientation, flipping it if the stronger side is black. Returns false if the
+// pieces do not match the material.
+bool orientBoard(const TablebaseBoard& board, const Material& material, bool flip, TablebaseBoard& oriented) {
+    bool used[MaxTablebasePieces] = {};
+
+    oriented.count = material.count();
+    oriented.turn = flip ? opponent(board.turn) : board.turn;
+
+    for (int slot = 0; slot < oriented.count; slot++)
+    {
+        oriented.type[slot] = slotType(material, slot, oriented.color[slot]);
+
+        ComandColor wanted = flip ? opponent(oriented.color[slot]) : oriented.color[slot];
+        int found = -1;
+
+        for (int i = 0; i < board.count && found < 0; i++)
+        {
+            if (!used[i] && board.type[i] == oriented.type[slot] && board.color[i] == wanted)
+            {
+                found = i;
+            }
+        }
+
+        if (found < 0)
+        {
+            return false;
+        }
+
+        used[found] = true;
+        oriented.square[slot] = flip ? flipRank(board.square[found]) : board.square[found];
+    }
+
+    return true;
+}
+
+TablebaseResult toResult(uint8_t value) {
+    TablebaseResult result;
+
+    if (value != 0 && value != Invalid)
+    {
+        result.plies = value - 1;
+        result.wdl = isWinValue(value) ? TablebaseResult::Win : TablebaseResult::Loss;
+    }
+
+    return result;
+}
+
+// Every material the set converts into by one capture or promotion
+std::vector<std::string> subMaterials(const Material& material) {
+    std::vector<std::string> result;
+    std::string strong, weak;
+
+    for (PieceType type : material.strong) strong += pieceLetter(type);
+    for (PieceType type : material.weak) weak += pieceLetter(type);
+
+    auto addMaterial = [&result](const std::string& a, const std::string& b) {
+        Material sub;
+
+        if (parseMaterial(a + b, sub) && std::find(result.begin(), result.end(), sub.name) == result.end())
+        {
+            result.push_back(sub.name);
+        }
+    };
+
+    for (int side = 0; side < 2; side++)
+    {
+        const std::string& mine = side == 0 ? strong : weak;
+        const std::string& theirs = side == 0 ? weak : strong;
+
+        for (size_t i = 1; i < mine.size(); i++)
+        {
+            std::string without = mine.substr(0, i) + mine.substr(i + 1);
+            addMaterial(sortSide(without), theirs);
+
+            if (mine[i] == 'P')
+            {
+                for (char promotion : std::string("QRBN"))
+                {
+                    std::string promoted = without + promotion;
+                    addMaterial(sortSide(promoted), theirs);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+// Runs work(begin, end) over [0, count) in chunks on the pool and waits for all of it
+template <typename Work>
+void parallelFor(ThreadPool& pool, uint64_t count, Work work) {
+    constexpr uint64_t ChunkSize = 1 << 16;
+
+    for (uint64_t begin = 0; begin < count; begin += ChunkSize)
+    {
+        uint64_t end = std::min(count, begin + ChunkSize);
+        pool.submit([&work, begin, end]() { work(begin, end); });
+    }
+
+    pool.wait();
+}
+
+void raiseTo(std::atomic<int>& value, int candidate) {
+    int current = value.load(std::memory_order_relaxed);
+
+    while (candidate > current && !value.compare_exchange_weak(current, candidate, std::memory_order_relaxed))
+    {
+    }
+}
+
+}
+
+struct Tablebases::Table {
+    Material material;
+    std::vector<uint8_t> memory;
+    MappedFile file;
+    const uint8_t* values = nullptr; // white to move, then black to move
+
+    uint8_t value(ComandColor turn, uint64_t index) const {
+        return values[static_cast<uint64_t>(turn) * material.size + index];
+    }
+};
+
+const Tablebases::Table* Tablebases::find(const std::string& name) const {
+    auto found = tables.find(name);
+    return found == tables.end() ? nullptr : found->second.get();
+}
+
+void Tablebases::add(std::shared_ptr<Table> table) {
+    largest = std::max(largest, table->material.count());
+    tables[table->material.name] = std::move(table);
+}
+
+int Tablebases::load(const std::string& directory) {
+    std::error_code error;
+    int loaded = 0;
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error))
+    {
+        if (entry.path().extension() != ".ctb")
+        {
+            continue;
+        }
+
+        auto table = std::make_shared<Table>();
+
+        // Probes read single entries anywhere in the table
+        if (!table->file.open(entry.path().string(), FileAccess::Random) || table->file.size() < HeaderSize
+            || std::memcmp(table->file.data().data(), FileMagic, sizeof(FileMagic)) != 0)
+        {
+            continue;
+        }
+
+        std::string name(table->file.data().substr(sizeof(FileMagic), HeaderSize - sizeof(FileMagic)));
+        name.erase(std::find(name.begin(), name.end(), '\0'), name.end());
+
+        if (!parseMaterial(name, table->material) || table->material.name != name
+            || table->file.size() != HeaderSize + 2 * table->material.size)
+        {
+            continue;
+        }
+
+        table->values = reinterpret_cast<const uint8_t*>(table->file.data().data()) + HeaderSize;
+        add(std::move(table));
+        loaded++;
+    }
+
+    return loaded;
+}
+
+bool Tablebases::probe(const Position& pos, TablebaseResult& result) const {
+    Bitboard occupied = pos.pieces();
+
+    if (popCount(occupied) > MaxTablebasePieces)
+    {
+        return false;
+    }
+
+    TablebaseBoard board;
+    board.turn = pos.sideToMove();
+
+    while (occupied)
+    {
+        int square = popLsb(occupied);
+
+        board.square[board.count] = square;
+        board.type[board.count] = pos.pieceOn(square);
+        board.color[board.count] = pos.colorOn(square);
+        board.count++;
+    }
+
+    return probe(board, result);
+}
+
+bool Tablebases::probe(const TablebaseBoard& board, TablebaseResult& result) const {
+    std::string white, black;
+
+    for (int i = 0; i < board.count; i++)
+    {
+        (board.color[i] == ComandColor::White ? white : black) += pieceLetter(board.type[i]);
+    }
+
+    white = sortSide(white);
+    black = sortSide(black);
+
+    if (isDrawnMaterial(white, black))
+    {
+        result = TablebaseResult();
+        return true;
+    }
+
+    bool flip = !strongerSide(white, black);
+    const Table* table = find(flip ? black + white : white + black);
+    TablebaseBoard oriented;
+
+    if (!table || !orientBoard(board, table->material, flip, oriented))
+    {
+        return false;
+    }
+
+    uint8_t value = table->value(oriented.turn, boardIndex(oriented, table->material.pawns));
+
+    if (value == Invalid)
+    {
+        return false;
+    }
+
+    result = toResult(value);
+    return true;
+}
+
+bool generateTablebase(const std::string& materialName, const std::string& directory, int threads, std::ostream& log) {
+    Material material;
+
+    if (!parseMaterial(materialName, material))
+    {
+        log << materialName << ": not a material set of two to " << MaxTablebasePieces << " pieces with mating chances" << std::endl;
+        return false;
+    }
+
+    if (tablebases.find(material.name))
+    {
+        return true;
+    }
+
+    // Captures and promotions lead into smaller tables, which have to exist first
+    for (const auto& sub : subMaterials(material))
+    {
+        if (!generateTablebase(sub, directory, threads, log))
+        {
+            return false;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    uint64_t size = material.size;
+    bool pawns = material.pawns;
+
+    std::unique_ptr<std::atomic<uint8_t>[]> values(new std::atomic<uint8_t>[2 * size]);
+    std::vector<uint8_t> exitWin(2 * size, 0);
+    std::vector<uint8_t> exitLoss(2 * size, 0);
+
+    std::atomic<int> lastPly{ 0 };
+
+    auto boardAt = [&material](uint64_t entry, TablebaseBoard& board) {
+        decodeIndex(material, entry % material.size, board);
+        board.turn = entry < material.size ? ComandColor::White : ComandColor::Black;
+    };
+
+    auto entryOf = [size, pawns](const TablebaseBoard& board) {
+        return static_cast<uint64_t>(board.turn) * size + boardIndex(board, pawns);
+    };
+
+    ThreadPool pool(threads);
+
+    // Positions that cannot occur, mates, stalemates, and what the captures and promotions lead to
+    parallelFor(pool, 2 * size, [&](uint64_t begin, uint64_t end) {
+        TablebaseBoard board;
+
+        for (uint64_t entry = begin; entry < end; entry++)
+        {
+            boardAt(entry, board);
+
+            // Two pieces on a square, a pawn on the first or last rank, or a
+            // board that symmetry maps to another index
+            Bitboard occupied = board.occupied();
+            bool valid = popCount(occupied) == board.count && boardIndex(board, pawns) == entry % size;
+
+            for (int i = 0; i < board.count && valid; i++)
+            {
+                valid = !(board.type[i] == PieceType::Pawn && (rankOf(board.square[i]) == 0 || rankOf(board.square[i]) == 7));
+            }
+
+            if (!valid || isAttacked(board, kingOf(board, opponent(board.turn)), board.turn, occupied))
+            {
+                values[entry].store(Invalid, std::memory_order_relaxed);
+                continue;
+            }
+
+            int moves = 0, inTable = 0, bestWin = 0, worstLoss = 0;
+            bool exitDraw = false;
+
+            forEachMove(board, [&](const TablebaseBoard& after, bool exit) {
+                moves++;
+
+                if (!exit)
+                {
+                    inTable++;
+                    return;
+                }
+
+                TablebaseResult next;
+                tablebases.probe(after, next);
+
+                if (next.wdl == TablebaseResult::Loss)
+                {
+                    bestWin = bestWin ? std::min(bestWin, next.plies + 1) : next.plies + 1;
+                }
+                else if (next.wdl == TablebaseResult::Win)
+                {
+                    worstLoss = std::max(worstLoss, next.plies + 1);
+                }
+                else
+                {
+                    exitDraw = true;
+                }
+            });
+
+            uint8_t value = 0;
+
+            if (moves == 0)
+            {
+                value = isAttacked(board, kingOf(board, board.turn), opponent(board.turn), occupied) ? encodeValue(0) : 0;
+            }
+            else if (inTable == 0)
+            {
+                value = bestWin ? encodeValue(bestWin) : exitDraw ? 0 : encodeValue(worstLoss);
+            }
+            else
+            {
+                exitWin[entry] = static_cast<uint8_t>(std::min(bestWin, MaxPlies));
+                exitLoss[entry] = exitDraw ? ExitDraw : static_cast<uint8_t>(std::min(worstLoss, MaxPlies));
+            }
+
+            values[entry].store(value, std::memory_order_relaxed);
+
+            if (value)
+            {
+                raiseTo(lastPly, value - 1);
+            }
+
+            raiseTo(lastPly, exitWin[entry]);
+        }
+    });
+
+    // Retrograde passes: a position lost in ply - 1 makes every predecessor a win in ply;
+    // a position won in ply - 1 makes a predecessor lost once all its moves lose
+    bool changed = true;
+
+    for (int ply = 1; ply <= MaxPlies && (changed || ply <= lastPly.load() + 1); ply++)
+    {
+        std::atomic<bool> anyChange{ false };
+
+        parallelFor(pool, 2 * size, [&](uint64_t begin, uint64_t end) {
+            TablebaseBoard board;
+            bool local = false;
+
+            for (uint64_t entry = begin; entry < end; entry++)
+            {
+                uint8_t value = values[entry].load(std::memory_order_relaxed);
+
+                if (value == 0 && exitWin[entry] == ply)
+                {
+                    uint8_t expected = 0;
+                    local |= values[entry].compare_exchange_strong(expected, encodeValue(ply));
+                    continue;
+                }
+
+                // Only the positions decided in the previous pass
+                if (value != ply || value == Invalid)
+                {
+                    continue;
+                }
+
+                boardAt(entry, board);
+                bool lost = !isWinValue(value);
+
+                forEachPredecessor(board, [&](const TablebaseBoard& before) {
+                    uint64_t previous = entryOf(before);
+                    uint8_t expected = 0;
+
+                    if (values[previous].load(std::memory_order_relaxed) != 0)
+                    {
+                        return;
+                    }
+
+                    if (lost)
+                    {
+                        local |= values[previous].compare_exchange_strong(expected, encodeValue(ply));
+                        return;
+                    }
+
+                    if (exitWin[previous] || exitLoss[previous] == ExitDraw)
+                    {
+                        return;
+                    }
+
+                    // Lost only if every move of the predecessor leads to a win for the other side
+                    int longest = exitLoss[previous];
+                    bool allWin = true;
+
+                    forEachMove(before, [&](const TablebaseBoard& after, bool exit) {
+                        if (exit || !allWin)
+                        {
+                            return;
+                        }
+
+                        uint8_t next = values[entryOf(after)].load(std::memory_order_relaxed);
+
+                        if (isWinValue(next))
+                        {
+                            longest = std::max(longest, static_cast<int>(next));
+                        }
+                        else
+                        {
+                            allWin = false;
+                        }
+                    });
+
+                    if (allWin && values[previous].compare_exchange_strong(expected, encodeValue(longest)))
+                    {
+                        raiseTo(lastPly, longest);
+                        local = true;
+                    }
+                });
+            }
+
+            if (local)
+            {
+                anyChange = true;
+            }
+        });
+
+        changed = anyChange;
+    }
+
+    auto table = std::make_shared<Tablebases::Table>();
+
+    table->material = material;
+    table->memory.resize(2 * size);
+
+    uint64_t positions = 0, wins = 0;
+    int longest = 0;
+
+    for (uint64_t entry = 0; entry < 2 * size; entry++)
+    {
+        uint8_t value = values[entry].load(std::memory_order_relaxed);
+        table->memory[entry] = value;
+
+        if (value != Invalid)
+        {
+            positions++;
+
+            if (value)
+            {
+                wins += isWinValue(value);
+                longest = std::max(longest, value - 1);
+            }
+        }
+    }
+
+    table->values = table->memory.data();
+
+    std::filesystem::path path = std::filesystem::path(directory) / (material.name + ".ctb");
+    std::ofstream out(path, std::ios::binary);
+    char header[HeaderSize] = {};
+
+    std::memcpy(header, FileMagic, sizeof(FileMagic));
+    std::memcpy(header + sizeof(FileMagic), material.name.data(), material.name.size());
+
+    out.write(header, HeaderSize);
+    out.write(reinterpret_cast<const char*>(table->memory.data()), static_cast<std::streamsize>(table->memory.size()));
+
+    if (!out)
+    {
+        log << material.name << ": cannot write " << path.string() << std::endl;
+        return false;
+    }
+
+    tablebases.add(std::move(table));
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    log << material.name << ": " << positions << " positions, " << wins << " won for the side to move, longest mate "
+        << longest << " plies, " << seconds << " s" << std::endl;
+
+    return true;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "Position.h"
+
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Endgame tablebases: for every position of a material set such as KQK or
+// KBNK, whether the side to move wins, draws or loses and how many plies the
+// mate takes with best play. Tables are built by retrograde analysis with
+// generateTablebase() and stored as one .ctb file per material set.
+//
+// A table lists its pieces as the stronger side's king, the weaker side's
+// king, then the other pieces of the stronger side and of the weaker side.
+// The board is turned so that the stronger king is on a1-d1-d4 (a1-d4 on the
+// queenside files if there are pawns), which shrinks the table eightfold
+// (twofold with pawns); positions with the weaker side as white are looked up
+// with the board flipped. Castling and en passant rights are ignored.
+
+constexpr int MaxTablebasePieces = 4;
+
+struct TablebaseResult {
+    enum Wdl {
+        Loss = -1, Draw = 0, Win = 1
+    };
+
+    Wdl wdl = Draw;
+
+    // Plies until mate with best play for both sides, 0 for a draw
+    int plies = 0;
+};
+
+// Pieces on the board in a table's order, without the rest of a Position
+struct TablebaseBoard {
+    int count = 0;
+    int square[MaxTablebasePieces];
+    PieceType type[MaxTablebasePieces];
+    ComandColor color[MaxTablebasePieces];
+    ComandColor turn = ComandColor::White;
+
+    Bitboard occupied() const {
+        Bitboard bb = 0;
+
+        for (int i = 0; i < count; i++)
+        {
+            bb |= squareBB(square[i]);
+        }
+
+        return bb;
+    }
+};
+
+// The loaded tables, each either built in memory or mapped from its file
+class Tablebases {
+private:
+    struct Table;
+
+    std::map<std::string, std::shared_ptr<Table>> tables;
+    int largest = 0;
+
+    friend bool generateTablebase(const std::string& material, const std::string& directory, int threads, std::ostream& log);
+
+    const Table* find(const std::string& name) const;
+    void add(std::shared_ptr<Table> table);
+
+public:
+    // Maps every .ctb file in the directory, returns how many were loaded
+    int load(const std::string& directory);
+
+    void clear() {
+        tables.clear();
+        largest = 0;
+    }
+
+    // Most pieces of any loaded table, 0 if there is none
+    int maxPieces() const {
+        return largest;
+    }
+
+    // Looks the position up from the side to move's view. Material without
+    // mating chances (bare kings, a single minor piece) is a draw without a table;
+    // returns false if there is no table for the material.
+    bool probe(const Position& pos, TablebaseResult& result) const;
+    bool probe(const TablebaseBoard& board, TablebaseResult& result) const;
+};
+
+extern Tablebases tablebases;
+
+// Builds the tables for a material set such as "KRK" or "KBNK", and first the
+// smaller ones it converts into by captures and promotions, on the given number
+// of threads. The tables are added to the global tablebases and written as
+// <material>.ctb files into the directory. Returns false if the material is not
+// valid or a file cannot be written; progress is reported to log.
+bool generateTablebase(const std::string& material, const std::string& directory, int threads, std::ostream& log);
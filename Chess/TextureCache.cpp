@@ -0,0 +1,168 @@
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+TextureCache textureCache;
+
+namespace {
+
+const char* pieceNames[6] = { "Pawn", "Knight", "Bishop", "Rook", "Queen", "King" };
+
+// Frame of each PieceType in the 16x32 sheets, which go Pawn, Knight, Rook, Bishop, Queen, King
+constexpr int sheetFrame[6] = { 0, 1, 3, 2, 4, 5 };
+constexpr unsigned FrameWidth = 16;
+constexpr unsigned FrameHeight = 32;
+
+// A 2x2 white block to the right of the pieces
+constexpr unsigned WhiteBlockX = 6 * TextureCache::PieceSize;
+
+const char* styleDirectory(FigureStyle style) {
+    switch (style)
+    {
+    case FigureStyle::Style1: return "Skins/memeSkins/";
+    case FigureStyle::Style2: return "Skins/memeSkins2/";
+    default: return "Skins/Default/";
+    }
+}
+
+// Fits the image into size x size keeping its aspect ratio. Enlarging uses the
+// nearest pixel so pixel art stays sharp, shrinking averages the covered pixels.
+sf::Image scaleImage(const sf::Image& source, unsigned size) {
+    sf::Vector2u from = source.getSize();
+    float scale = static_cast<float>(size) / std::max(from.x, from.y);
+    unsigned width = std::max(1u, static_cast<unsigned>(from.x * scale + 0.5f));
+    unsigned height = std::max(1u, static_cast<unsigned>(from.y * scale + 0.5f));
+
+    sf::Image result;
+    result.create(width, height, sf::Color::Transparent);
+
+    for (unsigned y = 0; y < height; y++)
+    {
+        for (unsigned x = 0; x < width; x++)
+        {
+            unsigned x0 = x * from.x / width, x1 = std::max(x0 + 1, (x + 1) * from.x / width);
+            unsigned y0 = y * from.y / height, y1 = std::max(y0 + 1, (y + 1) * from.y / height);
+            unsigned r = 0, g = 0, b = 0, a = 0, count = 0;
+
+            for (unsigned sy = y0; sy < y1; sy++)
+            {
+                for (unsigned sx = x0; sx < x1; sx++)
+                {
+                    sf::Color c = source.getPixel(sx, sy);
+
+                    r += c.r * c.a;
+                    g += c.g * c.a;
+                    b += c.b * c.a;
+                    a += c.a;
+                    count++;
+                }
+            }
+
+            // Weighted by alpha so transparent pixels do not darken the edges
+            if (a > 0)
+            {
+                result.setPixel(x, y, sf::Color(r / a, g / a, b / a, a / count));
+            }
+        }
+    }
+
+    return result;
+}
+
+// The default skin comes from the packed sheets, falling back to the single images
+bool loadDefaultImage(sf::Image& image, ComandColor color, PieceType type) {
+    sf::Image sheet;
+    const char* sheetPath = (color == ComandColor::White) ? "16x32/WhitePieces-Sheet.png" : "16x32/BlackPieces-Sheet.png";
+
+    if (sheet.loadFromFile(sheetPath) && sheet.getSize().x >= 6 * FrameWidth)
+    {
+        int frame = sheetFrame[static_cast<int>(type)];
+
+        image.create(FrameWidth, FrameHeight, sf::Color::Transparent);
+        image.copy(sheet, 0, 0, sf::IntRect(frame * FrameWidth, 0, FrameWidth, FrameHeight));
+        return true;
+    }
+
+    std::string path = std::string(styleDirectory(FigureStyle::Default)) + (color == ComandColor::White ? "W_" : "B_") + pieceNames[static_cast<int>(type)] + ".png";
+    return image.loadFromFile(path);
+}
+
+bool loadImage(sf::Image& image, FigureStyle style, ComandColor color, PieceType type) {
+    if (style == FigureStyle::Default)
+    {
+        return loadDefaultImage(image, color, type);
+    }
+
+    std::string path = std::string(styleDirectory(style)) + (color == ComandColor::White ? "W_" : "B_") + pieceNames[static_cast<int>(type)];
+
+    // Some skins ship photos as .jpg
+    if (image.loadFromFile(path + ".png") || image.loadFromFile(path + ".jpg"))
+    {
+        return true;
+    }
+
+    std::cerr << "Load texture " << path << " - failed!" << std::endl;
+    return loadDefaultImage(image, color, type);
+}
+
+}
+
+TextureCache::Atlas& TextureCache::load(FigureStyle style) {
+    Atlas& atlas = atlases[static_cast<int>(style)];
+
+    if (atlas.texture)
+    {
+        return atlas;
+    }
+
+    sf::Image packed;
+    packed.create(WhiteBlockX + 2, 2 * PieceSize, sf::Color::Transparent);
+
+    for (unsigned y = 0; y < 2; y++)
+    {
+        for (unsigned x = 0; x < 2; x++)
+        {
+            packed.setPixel(WhiteBlockX + x, y, sf::Color::White);
+        }
+    }
+
+    for (int color = 0; color < 2; color++)
+    {
+        for (int type = 0; type < 6; type++)
+        {
+            sf::Image image;
+
+            if (!loadImage(image, style, static_cast<ComandColor>(color), static_cast<PieceType>(type)))
+            {
+                std::cerr << "Load texture " << pieceNames[type] << " - failed!" << std::endl;
+                continue;
+            }
+
+            sf::Image scaled = scaleImage(image, PieceSize);
+            sf::Vector2u size = scaled.getSize();
+            int left = type * PieceSize;
+            int top = color * PieceSize;
+
+            packed.copy(scaled, left, top);
+            atlas.rects[color][type] = sf::IntRect(left, top, size.x, size.y);
+        }
+    }
+
+    atlas.texture = std::make_unique<sf::Texture>();
+    atlas.texture->loadFromImage(packed);
+
+    return atlas;
+}
+
+const sf::Texture& TextureCache::atlas(FigureStyle style) {
+    return *load(style).texture;
+}
+
+sf::IntRect TextureCache::rect(FigureStyle style, ComandColor color, PieceType type) {
+    return load(style).rects[static_cast<int>(color)][static_cast<int>(type)];
+}
+
+sf::Vector2f TextureCache::whiteTexel() {
+    return sf::Vector2f(WhiteBlockX + 1.f, 1.f);
+}
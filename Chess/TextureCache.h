@@ -0,0 +1,45 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include "Bitboard.h"
+
+#include <memory>
+#include <string>
+
+enum class FigureStyle {
+    Default, Style1, Style2
+};
+
+constexpr int FigureStyleCount = 3;
+
+// Piece images shared by all figures. The twelve images of a skin are
+// loaded once, on first use, scaled once to the size they are drawn at and
+// packed into a single atlas texture (white pieces in the top row, black in
+// the bottom one), so the whole board can be drawn with that one texture.
+class TextureCache {
+private:
+    struct Atlas {
+        std::unique_ptr<sf::Texture> texture;
+        sf::IntRect rects[2][6];
+    };
+
+    Atlas atlases[FigureStyleCount];
+
+    Atlas& load(FigureStyle style);
+
+public:
+    // Longest side of a piece image on the board, in pixels
+    static constexpr unsigned PieceSize = 60;
+
+    const sf::Texture& atlas(FigureStyle style);
+
+    // Where the piece lies in the atlas of its skin
+    sf::IntRect rect(FigureStyle style, ComandColor color, PieceType type);
+
+    // Texture coordinates of an opaque white texel, so untextured shapes
+    // can be batched into the same vertex array as the pieces
+    static sf::Vector2f whiteTexel();
+};
+
+extern TextureCache textureCache;
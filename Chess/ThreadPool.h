@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads running submitted tasks. Every thread has its own
+// queue: it takes tasks from the front of its own and, once that is empty,
+// steals from the back of the others, so a few long tasks do not leave the
+// rest of the threads idle while work is still queued elsewhere.
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> threads;
+
+    // Guard the counters, so waiting threads cannot miss a wakeup
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    int queued = 0;
+    int pending = 0;
+    size_t nextQueue = 0;
+    bool quit = false;
+
+    bool take(size_t id, std::function<void()>& task) {
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            Queue& queue = *queues[(id + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (queue.tasks.empty())
+            {
+                continue;
+            }
+
+            if (i == 0)
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+            else
+            {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+            }
+
+            std::lock_guard<std::mutex> state(stateMutex);
+            queued--;
+            return true;
+        }
+
+        return false;
+    }
+
+    void work(size_t id) {
+        std::function<void()> task;
+
+        while (true)
+        {
+            if (take(id, task))
+            {
+                task();
+                task = nullptr;
+
+                std::lock_guard<std::mutex> state(stateMutex);
+
+                if (--pending == 0)
+                {
+                    allDone.notify_all();
+                }
+
+                continue;
+            }
+
+            std::unique_lock<std::mutex> state(stateMutex);
+            workAvailable.wait(state, [this]() { return quit || queued > 0; });
+
+            if (quit && queued == 0)
+            {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit ThreadPool(int threadCount) {
+        threadCount = std::max(1, threadCount);
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            queues.push_back(std::make_unique<Queue>());
+        }
+
+        for (int i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back(&ThreadPool::work, this, static_cast<size_t>(i));
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> state(stateMutex);
+            quit = true;
+        }
+
+        workAvailable.notify_all();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const {
+        return static_cast<int>(threads.size());
+    }
+
+    // Tasks are dealt to the queues in turn; any thread may end up running them
+    void submit(std::function<void()> task) {
+        size_t index;
+
+        {
+            std::lock_guard<std::mutex> state(stateMutex);
+            index = nextQueue++ % queues.size();
+            pending++;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+
+        {
+            std::lock_guard<std::mutex> state(stateMutex);
+            queued++;
+        }
+
+        workAvailable.notify_one();
+    }
+
+    // Blocks until every submitted task has finished
+    void wait() {
+        std::unique_lock<std::mutex> state(stateMutex);
+        allDone.wait(state, [this]() { return pending == 0; });
+    }
+};
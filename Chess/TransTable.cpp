@@ -0,0 +1,195 @@
+#include "TransTable.h"
+
+#include <algorithm>
+#include <atomic>
+
+TranspositionTable TT;
+
+namespace {
+
+// data layout: move 0-15, score 16-31, eval 32-47, depth 48-55, bound 56-57, age 58-63
+uint64_t pack(Move move, int score, int eval, int depth, Bound bound, uint8_t age) {
+    return static_cast<uint64_t>(move.raw())
+        | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+        | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32
+        | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+        | static_cast<uint64_t>(bound) << 56
+        | static_cast<uint64_t>(age & 63) << 58;
+}
+
+Move unpackMove(uint64_t data) {
+    return Move(data & 0x3F, (data >> 6) & 0x3F, (data >> 12) & 0xF);
+}
+
+int unpackDepth(uint64_t data) {
+    return static_cast<int8_t>(data >> 48);
+}
+
+Bound unpackBound(uint64_t data) {
+    return static_cast<Bound>((data >> 56) & 3);
+}
+
+uint8_t unpackAge(uint64_t data) {
+    return static_cast<uint8_t>(data >> 58);
+}
+
+// High 64 bits of the 128-bit product, maps a key uniformly onto [0, count)
+size_t scaledIndex(uint64_t key, size_t count) {
+#if defined(__SIZEOF_INT128__)
+    return static_cast<size_t>((static_cast<unsigned __int128>(key) * count) >> 64);
+#elif defined(_MSC_VER) && defined(_WIN64)
+    return static_cast<size_t>(__umulh(key, count));
+#else
+    uint64_t keyHigh = key >> 32, keyLow = key & 0xFFFFFFFFULL;
+    uint64_t countHigh = static_cast<uint64_t>(count) >> 32, countLow = static_cast<uint64_t>(count) & 0xFFFFFFFFULL;
+    uint64_t middle = (keyLow * countLow >> 32) + (keyHigh * countLow & 0xFFFFFFFFULL) + keyLow * countHigh;
+    return static_cast<size_t>(keyHigh * countHigh + (keyHigh * countLow >> 32) + (middle >> 32));
+#endif
+}
+
+unsigned counterSlot() {
+    static std::atomic<unsigned> nextSlot{ 0 };
+    thread_local unsigned slot = nextSlot++;
+    return slot;
+}
+
+}
+
+TranspositionTable::TranspositionTable() {
+    resize(16);
+}
+
+void TranspositionTable::resize(size_t sizeMB) {
+    megabytes = std::max<size_t>(sizeMB, 1);
+    bucketCount = megabytes * 1024 * 1024 / sizeof(Bucket);
+    buckets = std::make_unique<Bucket[]>(bucketCount);
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        for (auto& entry : buckets[i].entries)
+        {
+            entry.keyXorData.store(0, std::memory_order_relaxed);
+            entry.data.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    for (auto& slot : counters)
+    {
+        slot.probes.store(0, std::memory_order_relaxed);
+        slot.hits.store(0, std::memory_order_relaxed);
+    }
+
+    age = 0;
+}
+
+void TranspositionTable::newSearch() {
+    age = (age + 1) & 63;
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucketFor(uint64_t key) const {
+    return buckets[scaledIndex(key, bucketCount)];
+}
+
+bool TranspositionTable::probe(uint64_t key, TTData& result) const {
+    Counters& slot = counters[counterSlot() % CounterSlots];
+    slot.probes.fetch_add(1, std::memory_order_relaxed);
+
+    for (const auto& entry : bucketFor(key).entries)
+    {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+
+        if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) == key && unpackBound(data) != Bound::None)
+        {
+            result.move = unpackMove(data);
+            result.score = static_cast<int16_t>(data >> 16);
+            result.eval = static_cast<int16_t>(data >> 32);
+            result.depth = unpackDepth(data);
+            result.bound = unpackBound(data);
+
+            slot.hits.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int eval, int depth, Bound bound) {
+    Bucket& bucket = bucketFor(key);
+    Entry* replace = nullptr;
+    int worst = 0;
+
+    for (auto& entry : bucket.entries)
+    {
+        uint64_t data = entry.data.load(std::memory_order_relaxed);
+
+        if ((entry.keyXorData.load(std::memory_order_relaxed) ^ data) == key)
+        {
+            // Same position: keep a deeper result from this search unless the new one is exact
+            if (bound != Bound::Exact && unpackAge(data) == age && depth + 3 < unpackDepth(data))
+            {
+                return;
+            }
+
+            // Keep the old best move if this search did not produce one
+            if (move == Move::none())
+            {
+                move = unpackMove(data);
+            }
+
+            replace = &entry;
+            break;
+        }
+
+        // Prefer to evict shallow entries and entries left over from earlier searches
+        int relativeAge = (age - unpackAge(data)) & 63;
+        int value = unpackDepth(data) - 8 * relativeAge;
+
+        if (!replace || value < worst)
+        {
+            replace = &entry;
+            worst = value;
+        }
+    }
+
+    uint64_t data = pack(move, score, eval, depth, bound, age);
+
+    replace->keyXorData.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+double TranspositionTable::hitRate() const {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+
+    for (const auto& slot : counters)
+    {
+        probes += slot.probes.load(std::memory_order_relaxed);
+        hits += slot.hits.load(std::memory_order_relaxed);
+    }
+
+    return probes ? 100.0 * hits / probes : 0.0;
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    size_t sample = std::min<size_t>(250, bucketCount);
+
+    for (size_t i = 0; i < sample; i++)
+    {
+        for (const auto& entry : buckets[i].entries)
+        {
+            uint64_t data = entry.data.load(std::memory_order_relaxed);
+
+            if (unpackBound(data) != Bound::None && unpackAge(data) == age)
+            {
+                used++;
+            }
+        }
+    }
+
+    return sample ? static_cast<int>(used * 1000 / (sample * BucketSize)) : 0;
+}
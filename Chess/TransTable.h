@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Move.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+enum class Bound : uint8_t {
+    None, Upper, Lower, Exact
+};
+
+// What a table entry remembers about a searched position
+struct TTData {
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    Bound bound;
+};
+
+// Hash table of search results shared by all search threads without locks.
+// An entry is two 64-bit words, the packed data and the key XOR the data:
+// a torn write from two racing threads fails the key check on probe and
+// reads as a miss instead of returning a mixed-up entry.
+class TranspositionTable {
+private:
+    struct Entry {
+        std::atomic<uint64_t> keyXorData;
+        std::atomic<uint64_t> data;
+    };
+
+    static constexpr int BucketSize = 4;
+
+    // Four entries fill one cache line
+    struct alignas(64) Bucket {
+        Entry entries[BucketSize];
+    };
+
+    struct alignas(64) Counters {
+        std::atomic<uint64_t> probes{ 0 };
+        std::atomic<uint64_t> hits{ 0 };
+    };
+
+    static constexpr int CounterSlots = 16;
+
+    std::unique_ptr<Bucket[]> buckets;
+    size_t bucketCount = 0;
+    size_t megabytes = 0;
+    uint8_t age = 0;
+
+    // Per-thread slots so statistics do not bounce one cache line between cores. More
+    // threads than slots share one, so the counters are still updated atomically.
+    mutable Counters counters[CounterSlots];
+
+    Bucket& bucketFor(uint64_t key) const;
+
+public:
+    TranspositionTable();
+
+    // Reallocates the table, dropping every entry
+    void resize(size_t sizeMB);
+
+    void clear();
+
+    // Ages the table so entries of earlier searches are replaced first
+    void newSearch();
+
+    bool probe(uint64_t key, TTData& data) const;
+    void store(uint64_t key, Move move, int score, int eval, int depth, Bound bound);
+
+    size_t sizeMB() const {
+        return megabytes;
+    }
+
+    // Share of probes that found their position, in percent
+    double hitRate() const;
+
+    // Permille of sampled entries written during the current search
+    int hashfull() const;
+};
+
+extern TranspositionTable TT;
@@ -0,0 +1,387 @@
+#include "Uci.h"
+
+#include "Book.h"
+#include "MoveGen.h"
+#include "Nnue.h"
+#include "Search.h"
+#include "Tablebase.h"
+#include "TransTable.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <condition_variable>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr int MaxHashMB = 4096;
+constexpr int MaxThreads = 256;
+constexpr int MaxPawnHashMB = 256;
+
+// Time kept in reserve for the GUI and the transmission of the move
+constexpr int64_t MoveOverhead = 30;
+
+std::string moveToUci(Move move) {
+    return (move == Move::none()) ? "0000" : move.toString();
+}
+
+// "cp <centipawns>", or "mate <moves>" with a negative count when the side to move is mated
+std::string scoreToUci(int score) {
+    if (score >= ScoreMateInMaxPly)
+    {
+        return "mate " + std::to_string((ScoreMate - score + 1) / 2);
+    }
+
+    if (score <= -ScoreMateInMaxPly)
+    {
+        return "mate " + std::to_string(-(ScoreMate + score) / 2);
+    }
+
+    return "cp " + std::to_string(score);
+}
+
+// Time for this move out of the remaining clock: an equal share of the moves to
+// the next time control (or of 30 moves), plus most of the increment
+int64_t allocateTime(int64_t remaining, int64_t increment, int movesToGo) {
+    int64_t share = remaining / std::max(movesToGo, 1) + increment * 3 / 4;
+    return std::max<int64_t>(1, std::min(share, remaining - MoveOverhead));
+}
+
+class UciSession {
+private:
+    std::ostream& out;
+    std::mutex outMutex;
+
+    Position pos;
+    Search search;
+    std::thread worker;
+
+    OpeningBook book;
+    bool ownBook = true;
+
+    // An infinite search holds its best move back until "stop" arrives
+    std::mutex stopMutex;
+    std::condition_variable stopSignal;
+    bool stopReceived = false;
+
+    void send(const std::string& line) {
+        std::lock_guard<std::mutex> lock(outMutex);
+        out << line << std::endl;
+    }
+
+    void stop() {
+        search.stop();
+
+        {
+            std::lock_guard<std::mutex> lock(stopMutex);
+            stopReceived = true;
+        }
+
+        stopSignal.notify_all();
+
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+
+    void setOption(std::istringstream& args);
+    void setPosition(std::istringstream& args);
+    void go(std::istringstream& args);
+
+public:
+    explicit UciSession(std::ostream& output) : out(output) {
+        pos.setFen(StartFen);
+    }
+
+    ~UciSession() {
+        stop();
+    }
+
+    // Returns false once the session should end
+    bool handle(const std::string& line);
+};
+
+// setoption name <name> [value <value>]; the name may contain spaces, and so may a book path
+void UciSession::setOption(std::istringstream& args) {
+    std::string token, name, value;
+
+    args >> token;
+
+    while (args >> token && token != "value")
+    {
+        name += (name.empty() ? "" : " ") + token;
+    }
+
+    while (args >> token)
+    {
+        value += (value.empty() ? "" : " ") + token;
+    }
+
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+
+    stop();
+
+    if (name == "hash")
+    {
+        TT.resize(std::clamp(std::atoi(value.c_str()), 1, MaxHashMB));
+    }
+    else if (name == "threads")
+    {
+        search.setThreads(std::clamp(std::atoi(value.c_str()), 1, MaxThreads));
+    }
+    else if (name == "pawnhash")
+    {
+        search.setPawnHash(std::clamp(std::atoi(value.c_str()), 1, MaxPawnHashMB));
+    }
+    else if (name == "clear hash")
+    {
+        TT.clear();
+        search.clearPawnHash();
+    }
+    else if (name == "tablebasepath")
+    {
+        tablebases.clear();
+
+        if (!value.empty() && value != "<empty>")
+        {
+            send("info string " + std::to_string(tablebases.load(value)) + " tablebases loaded from " + value);
+        }
+    }
+    else if (name == "evalfile")
+    {
+        nnue.clear();
+
+        if (!value.empty() && value != "<empty>" && !nnue.load(value))
+        {
+            send("info string cannot load network " + value);
+        }
+    }
+    else if (name == "ownbook")
+    {
+        ownBook = (value == "true");
+    }
+    else if (name == "bookfile")
+    {
+        if (value.empty() || value == "<empty>")
+        {
+            book.close();
+        }
+        else if (!book.open(value))
+        {
+            send("info string cannot open book " + value);
+        }
+    }
+    else
+    {
+        send("info string unknown option " + name);
+    }
+}
+
+// position (startpos | fen <fen>) [moves <move>...]
+void UciSession::setPosition(std::istringstream& args) {
+    std::string token, fen;
+
+    args >> token;
+
+    if (token == "startpos")
+    {
+        fen = StartFen;
+        args >> token;
+    }
+    else if (token == "fen")
+    {
+        while (args >> token && token != "moves")
+        {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    stop();
+
+    Position next;
+
+    if (!next.setFen(fen))
+    {
+        send("info string invalid fen " + fen);
+        return;
+    }
+
+    // The moves are played rather than set up, so the search sees repetitions of earlier positions
+    while (args >> token)
+    {
+        MoveList moves;
+        generateMoves(next, moves);
+
+        auto found = std::find_if(moves.begin(), moves.end(), [&token](Move move) { return move.toString() == token; });
+
+        if (found == moves.end())
+        {
+            send("info string illegal move " + token);
+            break;
+        }
+
+        next.makeMove(*found);
+    }
+
+    pos = next;
+}
+
+// go [depth N] [movetime ms] [nodes N] [wtime ms] [btime ms] [winc ms] [binc ms] [movestogo N] [infinite]
+void UciSession::go(std::istringstream& args) {
+    stop();
+
+    SearchLimits limits;
+    int64_t time[2] = { 0, 0 };
+    int64_t increment[2] = { 0, 0 };
+    int movesToGo = 30;
+    bool infinite = false;
+    std::string token;
+
+    while (args >> token)
+    {
+        if (token == "depth") args >> limits.depth;
+        else if (token == "movetime") args >> limits.movetime;
+        else if (token == "nodes") args >> limits.nodes;
+        else if (token == "wtime") args >> time[0];
+        else if (token == "btime") args >> time[1];
+        else if (token == "winc") args >> increment[0];
+        else if (token == "binc") args >> increment[1];
+        else if (token == "movestogo") args >> movesToGo;
+        else if (token == "infinite") infinite = true;
+    }
+
+    limits.depth = std::clamp(limits.depth, 1, MaxPly - 1);
+
+    // A book move is played at once, unless the search is meant to analyse
+    if (ownBook && book.isOpen() && !infinite)
+    {
+        Move move = book.pick(pos);
+
+        if (move != Move::none())
+        {
+            send("info string book move");
+            send("bestmove " + moveToUci(move));
+            return;
+        }
+    }
+
+    int side = static_cast<int>(pos.sideToMove());
+
+    if (!infinite && !limits.movetime && time[side] > 0)
+    {
+        limits.movetime = allocateTime(time[side], increment[side], movesToGo);
+    }
+
+    search.resetStop();
+
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopReceived = false;
+    }
+
+    worker = std::thread([this, root = pos, limits, infinite]() {
+        Move best = search.run(root, limits, [this](const SearchReport& report) {
+            std::string line = "info depth " + std::to_string(report.depth)
+                + " score " + scoreToUci(report.score)
+                + " nodes " + std::to_string(report.nodes)
+                + " nps " + std::to_string(report.nps())
+                + " time " + std::to_string(report.time)
+                + " hashfull " + std::to_string(TT.hashfull())
+                + " pv";
+
+            for (Move move : report.pv)
+            {
+                line += " " + moveToUci(move);
+            }
+
+            send(line);
+        });
+
+        if (infinite)
+        {
+            std::unique_lock<std::mutex> lock(stopMutex);
+            stopSignal.wait(lock, [this]() { return stopReceived; });
+        }
+
+        send("bestmove " + moveToUci(best));
+    });
+}
+
+bool UciSession::handle(const std::string& line) {
+    std::istringstream args(line);
+    std::string command;
+
+    args >> command;
+
+    if (command == "uci")
+    {
+        send("id name Chess");
+        send("id author gubarger");
+        send("option name Hash type spin default " + std::to_string(TT.sizeMB()) + " min 1 max " + std::to_string(MaxHashMB));
+        send("option name Threads type spin default " + std::to_string(search.threads()) + " min 1 max " + std::to_string(MaxThreads));
+        send("option name PawnHash type spin default " + std::to_string(search.pawnHash()) + " min 1 max " + std::to_string(MaxPawnHashMB));
+        send("option name Clear Hash type button");
+        send("option name TablebasePath type string default <empty>");
+        send("option name EvalFile type string default <empty>");
+        send("option name OwnBook type check default true");
+        send("option name BookFile type string default <empty>");
+        send("uciok");
+    }
+    else if (command == "isready")
+    {
+        send("readyok");
+    }
+    else if (command == "ucinewgame")
+    {
+        stop();
+        TT.clear();
+        search.clearPawnHash();
+        pos.setFen(StartFen);
+    }
+    else if (command == "setoption")
+    {
+        setOption(args);
+    }
+    else if (command == "position")
+    {
+        setPosition(args);
+    }
+    else if (command == "go")
+    {
+        go(args);
+    }
+    else if (command == "stop")
+    {
+        stop();
+    }
+    else if (command == "quit")
+    {
+        return false;
+    }
+    else if (!command.empty())
+    {
+        send("info string unknown command " + command);
+    }
+
+    return true;
+}
+
+}
+
+void runUci(std::istream& in, std::ostream& out) {
+    UciSession session(out);
+    std::string line;
+
+    while (std::getline(in, line) && session.handle(line))
+    {
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+
+// Runs the engine as a Universal Chess Interface engine: reads commands from
+// in until "quit" or the end of input and writes the replies to out. The
+// search runs on its own thread, so "stop" and "isready" are answered while
+// it thinks.
+void runUci(std::istream& in, std::ostream& out);
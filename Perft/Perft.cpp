@@ -0,0 +1,244 @@
+// Headless perft: counts the leaf nodes of the legal move tree to verify
+// move generation against known values and to measure its throughput
+
+#include "Position.h"
+#include "MoveGen.h"
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using std::cout, std::endl, std::vector;
+
+struct PerftCase {
+    std::string name;
+    std::string fen;
+    vector<uint64_t> nodes; // reference counts for depth 1, 2, ...
+};
+
+// Standard positions from the Chess Programming Wiki perft results page
+const vector<PerftCase> perftCases = {
+    { "Start position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+        { 20, 400, 8902, 197281, 4865609, 119060324 } },
+    { "Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        { 48, 2039, 97862, 4085603, 193690690 } },
+    { "Position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        { 14, 191, 2812, 43238, 674624, 11030083, 178633661 } },
+    { "Position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        { 6, 264, 9467, 422333, 15833292, 706045033 } },
+    { "Position 4 mirrored", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1",
+        { 6, 264, 9467, 422333, 15833292, 706045033 } },
+    { "Position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        { 44, 1486, 62379, 2103487, 89941194 } },
+    { "Position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+        { 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+uint64_t perft(Position& pos, int depth) {
+    MoveList moves;
+    generateMoves(pos, moves);
+
+    // Bulk counting: the leaves are the legal moves of the last ply
+    if (depth <= 1)
+    {
+        return depth == 1 ? moves.size() : 1;
+    }
+
+    uint64_t nodes = 0;
+
+    for (Move move : moves)
+    {
+        pos.makeMove(move);
+        nodes += perft(pos, depth - 1);
+        pos.unmakeMove();
+    }
+
+    return nodes;
+}
+
+// Counts every root move's subtree, handing the root moves out to the threads one at a time
+vector<uint64_t> perftRoot(const Position& pos, const MoveList& rootMoves, int depth, int threadCount) {
+    vector<uint64_t> counts(rootMoves.size());
+    std::atomic<int> next{ 0 };
+
+    auto worker = [&]() {
+        Position child = pos;
+
+        for (int i = next++; i < rootMoves.size(); i = next++)
+        {
+            child.makeMove(rootMoves[i]);
+            counts[i] = perft(child, depth - 1);
+            child.unmakeMove();
+        }
+    };
+
+    vector<std::thread> threads;
+
+    for (int i = 1; i < threadCount; i++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    return counts;
+}
+
+// Returns the node count, printing one line per root move in divide mode
+uint64_t runPerft(const Position& pos, int depth, int threadCount, bool divide) {
+    if (depth == 0)
+    {
+        return 1;
+    }
+
+    MoveList rootMoves;
+    generateMoves(pos, rootMoves);
+
+    vector<uint64_t> counts = perftRoot(pos, rootMoves, depth, threadCount);
+    uint64_t total = 0;
+
+    for (int i = 0; i < rootMoves.size(); i++)
+    {
+        total += counts[i];
+
+        if (divide)
+        {
+            cout << "  " << rootMoves[i].toString() << ": " << counts[i] << endl;
+        }
+    }
+
+    return total;
+}
+
+void printUsage() {
+    cout << "usage: Perft [options]" << endl
+        << "  --depth N     deepest depth to search (default 5)" << endl
+        << "  --fen FEN     count a single position instead of the built-in suite" << endl
+        << "  --divide      print the node count below every root move" << endl
+        << "  --threads N   split the root moves across N threads (default: all cores)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int maxDepth = 5;
+    int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    bool divide = false;
+    std::string fen;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--depth" && i + 1 < argc)
+        {
+            maxDepth = std::stoi(argv[++i]);
+        }
+        else if (arg == "--fen" && i + 1 < argc)
+        {
+            fen = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--divide")
+        {
+            divide = true;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    initBitboards();
+
+    vector<PerftCase> cases = perftCases;
+
+    if (!fen.empty())
+    {
+        cases = { { "Custom position", fen, {} } };
+    }
+
+    cout << "Perft, " << threadCount << " thread(s)" << endl;
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalSeconds = 0;
+
+    for (const auto& test : cases)
+    {
+        Position pos;
+
+        if (!pos.setFen(test.fen))
+        {
+            std::cerr << "Invalid FEN: " << test.fen << endl;
+            return 2;
+        }
+
+        cout << endl << test.name << ": " << test.fen << endl;
+
+        int depthLimit = test.nodes.empty() ? maxDepth : std::min<int>(maxDepth, static_cast<int>(test.nodes.size()));
+
+        for (int depth = 1; depth <= depthLimit; depth++)
+        {
+            bool lastDepth = depth == depthLimit;
+
+            auto start = std::chrono::steady_clock::now();
+            uint64_t nodes = runPerft(pos, depth, threadCount, divide && lastDepth);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            totalNodes += nodes;
+            totalSeconds += seconds;
+
+            cout << "  depth " << std::setw(2) << depth
+                << "  nodes " << std::setw(12) << nodes
+                << "  time " << std::fixed << std::setprecision(3) << seconds << " s"
+                << "  nps " << std::setw(12) << static_cast<uint64_t>(nodes / std::max(seconds, 1e-9));
+
+            if (depth <= static_cast<int>(test.nodes.size()))
+            {
+                uint64_t expected = test.nodes[depth - 1];
+
+                if (nodes == expected)
+                {
+                    cout << "  OK" << endl;
+                }
+                else
+                {
+                    cout << "  FAILED" << endl;
+                    std::cerr << "*** " << test.name << " depth " << depth << ": expected " << expected
+                        << " nodes, got " << nodes << " ***" << endl;
+                    failures++;
+                }
+            }
+            else
+            {
+                cout << endl;
+            }
+        }
+    }
+
+    cout << endl << "Total " << totalNodes << " nodes in " << std::fixed << std::setprecision(3) << totalSeconds
+        << " s, " << static_cast<uint64_t>(totalNodes / std::max(totalSeconds, 1e-9)) << " nps" << endl;
+
+    if (failures)
+    {
+        std::cerr << failures << " perft count(s) differ from the reference values" << endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Headless PGN database check: replays every game through the move generator
+// and reports the games with an illegal move, a bad FEN tag or no result
+
+#include "Position.h"
+#include "Pgn.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+
+using std::cout, std::endl, std::vector;
+
+struct BadGame {
+    size_t offset = 0;
+    size_t index = 0; // number of the game within its chunk, from 0
+    std::string reason;
+};
+
+// A slice of the file that starts at a game and ends before the next one
+struct Chunk {
+    size_t begin = 0;
+    size_t end = 0;
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    vector<BadGame> bad;
+};
+
+// Start of the first tag section at or after from: a '[' at the start of a line
+// that follows a line which is not itself a tag
+size_t nextGameStart(std::string_view text, size_t from) {
+    while (from < text.size())
+    {
+        size_t bracket = text.find("\n[", from);
+
+        if (bracket == std::string_view::npos)
+        {
+            return text.size();
+        }
+
+        size_t lineStart = (bracket == 0) ? 0 : text.rfind('\n', bracket - 1);
+        lineStart = (lineStart == std::string_view::npos) ? 0 : lineStart + 1;
+
+        if (bracket == lineStart || text[lineStart] != '[')
+        {
+            return bracket + 1;
+        }
+
+        from = bracket + 1;
+    }
+
+    return text.size();
+}
+
+// Cuts the text into pieces of about chunkSize bytes, moving every cut forward to a game boundary
+vector<Chunk> splitChunks(std::string_view text, size_t chunkSize) {
+    vector<Chunk> chunks;
+    size_t begin = 0;
+
+    while (begin < text.size())
+    {
+        size_t end = (text.size() - begin > chunkSize) ? nextGameStart(text, begin + chunkSize) : text.size();
+
+        chunks.push_back(Chunk());
+        chunks.back().begin = begin;
+        chunks.back().end = end;
+
+        begin = end;
+    }
+
+    return chunks;
+}
+
+void checkChunk(std::string_view text, Chunk& chunk) {
+    PgnReader reader(text.substr(chunk.begin, chunk.end - chunk.begin), chunk.begin);
+    PgnGame game;
+    Position pos;
+    std::string error;
+
+    while (reader.next(game))
+    {
+        if (!replayGame(game, pos, error))
+        {
+            chunk.bad.push_back({ game.offset, chunk.games, error });
+        }
+        else if (game.result.empty())
+        {
+            chunk.bad.push_back({ game.offset, chunk.games, "no result, the game is cut off" });
+        }
+
+        chunk.games++;
+        chunk.moves += game.moves.size();
+    }
+}
+
+void printUsage() {
+    cout << "usage: PgnCheck <file.pgn> [options]" << endl
+        << "  --threads N   worker threads (default: all cores)" << endl
+        << "  --chunk KB    size of the pieces the file is split into (default: file size / 16 per thread)" << endl
+        << "  --quiet       print only the summary, not every bad game" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    size_t chunkSize = 0;
+    bool quiet = false;
+    std::string path;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--threads" && i + 1 < argc)
+        {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (arg == "--chunk" && i + 1 < argc)
+        {
+            chunkSize = static_cast<size_t>(std::max(1, std::stoi(argv[++i]))) * 1024;
+        }
+        else if (arg == "--quiet")
+        {
+            quiet = true;
+        }
+        else if (path.empty() && !arg.empty() && arg[0] != '-')
+        {
+            path = arg;
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    if (path.empty())
+    {
+        printUsage();
+        return 2;
+    }
+
+    MappedFile file;
+
+    if (!file.open(path))
+    {
+        std::cerr << "Cannot open " << path << endl;
+        return 2;
+    }
+
+    initBitboards();
+
+    std::string_view text = file.data();
+
+    // Many more chunks than threads, so that stealing can even out slow chunks
+    if (!chunkSize)
+    {
+        chunkSize = std::max<size_t>(64 * 1024, text.size() / (static_cast<size_t>(threadCount) * 16));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    vector<Chunk> chunks = splitChunks(text, chunkSize);
+
+    {
+        ThreadPool pool(threadCount);
+
+        for (auto& chunk : chunks)
+        {
+            pool.submit([text, &chunk]() { checkChunk(text, chunk); });
+        }
+
+        pool.wait();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::max(1e-6, std::chrono::duration<double>(end - start).count());
+
+    uint64_t games = 0, moves = 0, badGames = 0;
+
+    for (const auto& chunk : chunks)
+    {
+        // Game numbers within the file follow from the counts of the chunks before
+        if (!quiet)
+        {
+            for (const auto& bad : chunk.bad)
+            {
+                cout << "game " << games + bad.index + 1 << " at offset " << bad.offset << ": " << bad.reason << endl;
+            }
+        }
+
+        games += chunk.games;
+        moves += chunk.moves;
+        badGames += chunk.bad.size();
+    }
+
+    cout << std::fixed << std::setprecision(2);
+    cout << games << " games, " << moves << " moves, " << badGames << " bad, checked in " << seconds << " s with "
+        << threadCount << " threads and " << chunks.size() << " chunks" << endl;
+    cout << std::setprecision(0) << games / seconds << " games/s, " << moves / seconds << " moves/s, "
+        << std::setprecision(1) << text.size() / seconds / (1024 * 1024) << " MB/s" << endl;
+
+    return badGames ? 1 : 0;
+}
@@ -0,0 +1,80 @@
+// Endgame tablebase generator: builds the distance-to-mate tables for the
+// given material sets by retrograde analysis and writes them as .ctb files
+
+#include "Position.h"
+#include "Tablebase.h"
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <thread>
+#include <filesystem>
+
+using std::cout, std::endl, std::vector;
+
+void printUsage() {
+    cout << "usage: TbGen [options] MATERIAL..." << endl
+        << "  MATERIAL      e.g. KQK KRK KPK KBNK, up to " << MaxTablebasePieces << " pieces" << endl
+        << "  --dir PATH    directory the tables are written to and read from (default tb)" << endl
+        << "  --threads N   worker threads (default: all cores)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int threadCount = std::max(1u, std::thread::hardware_concurrency());
+    std::string directory = "tb";
+    vector<std::string> materials;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+
+        if (arg == "--dir" && i + 1 < argc)
+        {
+            directory = argv[++i];
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            threadCount = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (!arg.empty() && arg[0] == 'K')
+        {
+            materials.push_back(arg);
+        }
+        else
+        {
+            printUsage();
+            return arg == "--help" ? 0 : 2;
+        }
+    }
+
+    if (materials.empty())
+    {
+        printUsage();
+        return 2;
+    }
+
+    initBitboards();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+
+    // Tables that already exist are reused, also as the smaller tables of new ones
+    int existing = tablebases.load(directory);
+
+    if (existing)
+    {
+        cout << existing << " tables already in " << directory << endl;
+    }
+
+    for (const auto& material : materials)
+    {
+        if (!generateTablebase(material, directory, threadCount, cout))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}